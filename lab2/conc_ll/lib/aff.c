@@ -6,8 +6,28 @@
 #include <stdio.h>
 #include <sched.h>
 #include <string.h>
+#include <dirent.h>
 
 #define MT_CONF "MT_CONF"
+#define MT_POLICY "MT_POLICY"
+#define MT_NTHREADS "MT_NTHREADS"
+
+#define SYSFS_CPU "/sys/devices/system/cpu"
+
+/**
+ * Where a logical cpu lives, as reported by sysfs.
+ **/
+typedef struct {
+    unsigned int cpu;
+    int package;
+    int core;
+    int node;
+    int smt;  /* Index of this cpu among the hardware threads of its core. */
+    int rank; /* Position used for sorting by the placement policies. */
+} cpu_topo_t;
+
+static cpu_topo_t *topo;
+static unsigned int topo_ncpus;
 
 void setaffinity_oncpu(unsigned int cpu)
 {
@@ -38,11 +58,189 @@ static long parse_int(char *s)
     return ret;
 }
 
+static int read_sysfs_int(const char *path, int def)
+{
+    FILE *fp;
+    int ret;
+
+    fp = fopen(path, "r");
+    if (!fp)
+        return def;
+    if (fscanf(fp, "%d", &ret) != 1)
+        ret = def;
+    fclose(fp);
+    return ret;
+}
+
+static int cpu_node(unsigned int cpu)
+{
+    char path[128];
+    DIR *dir;
+    struct dirent *ent;
+    int node = 0;
+
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%u", cpu);
+    dir = opendir(path);
+    if (!dir)
+        return 0;
+    while ((ent = readdir(dir))) {
+        if (!strncmp(ent->d_name, "node", 4) &&
+            sscanf(ent->d_name + 4, "%d", &node) == 1)
+            break;
+    }
+    closedir(dir);
+    return node;
+}
+
+/**
+ * Discover the package, core and NUMA node of every online cpu (the cpus
+ * this process is allowed to run on) from /sys/devices/system/cpu.
+ **/
+static void topology_discover(void)
+{
+    cpu_set_t mask;
+    char path[128];
+    unsigned int i, j, cpu;
+
+    if (topo)
+        return;
+
+    if (sched_getaffinity(0, sizeof(mask), &mask)) {
+        perror("sched_getaffinity");
+        exit(1);
+    }
+
+    topo = malloc(sizeof(cpu_topo_t) * CPU_COUNT(&mask));
+    if (!topo) {
+        fprintf(stderr, "topology_discover: malloc failed\n");
+        exit(1);
+    }
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &mask))
+            continue;
+        topo[topo_ncpus].cpu = cpu;
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%u/topology/physical_package_id", cpu);
+        topo[topo_ncpus].package = read_sysfs_int(path, 0);
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%u/topology/core_id", cpu);
+        topo[topo_ncpus].core = read_sysfs_int(path, cpu);
+        topo[topo_ncpus].node = cpu_node(cpu);
+        topo_ncpus++;
+    }
+
+    for (i = 0; i < topo_ncpus; i++) {
+        topo[i].smt = 0;
+        for (j = 0; j < i; j++)
+            if (topo[j].package == topo[i].package && topo[j].core == topo[i].core)
+                topo[i].smt++;
+    }
+}
+
+/**
+ * compact: all physical cores of a package before moving to the next one,
+ *          hardware thread siblings only once every core is in use.
+ * socket:  fill a package completely, siblings included, before the next.
+ * scatter: round-robin over the packages, physical cores first.
+ **/
+static int cmp_compact(const void *a, const void *b)
+{
+    const cpu_topo_t *x = a, *y = b;
+
+    if (x->smt != y->smt)
+        return x->smt - y->smt;
+    if (x->package != y->package)
+        return x->package - y->package;
+    if (x->core != y->core)
+        return x->core - y->core;
+    return (int)x->cpu - (int)y->cpu;
+}
+
+static int cmp_socket(const void *a, const void *b)
+{
+    const cpu_topo_t *x = a, *y = b;
+
+    if (x->package != y->package)
+        return x->package - y->package;
+    return cmp_compact(a, b);
+}
+
+static int cmp_scatter(const void *a, const void *b)
+{
+    const cpu_topo_t *x = a, *y = b;
+
+    if (x->rank != y->rank)
+        return x->rank - y->rank;
+    return x->package - y->package;
+}
+
+static void get_policy_options(const char *policy, unsigned int *nr_cpus,
+                               unsigned int **cpus)
+{
+    cpu_topo_t *order;
+    unsigned int i, j;
+    char *e;
+
+    topology_discover();
+
+    e = getenv(MT_NTHREADS);
+    *nr_cpus = e ? (unsigned int)parse_int(e) : topo_ncpus;
+    if (*nr_cpus == 0) {
+        fprintf(stderr, "%s must be positive\n", MT_NTHREADS);
+        exit(1);
+    }
+
+    order = malloc(sizeof(cpu_topo_t) * topo_ncpus);
+    *cpus = malloc(sizeof(unsigned int) * (*nr_cpus));
+    if (!order || !*cpus) {
+        fprintf(stderr, "mt_get_options: malloc failed\n");
+        exit(1);
+    }
+    memcpy(order, topo, sizeof(cpu_topo_t) * topo_ncpus);
+
+    if (!strcmp(policy, "compact")) {
+        qsort(order, topo_ncpus, sizeof(cpu_topo_t), cmp_compact);
+    } else if (!strcmp(policy, "socket")) {
+        qsort(order, topo_ncpus, sizeof(cpu_topo_t), cmp_socket);
+    } else if (!strcmp(policy, "scatter")) {
+        /* Rank every cpu within its own package, then interleave packages. */
+        qsort(order, topo_ncpus, sizeof(cpu_topo_t), cmp_socket);
+        for (i = 0; i < topo_ncpus; i++) {
+            order[i].rank = 0;
+            for (j = 0; j < i; j++)
+                if (order[j].package == order[i].package)
+                    order[i].rank++;
+        }
+        qsort(order, topo_ncpus, sizeof(cpu_topo_t), cmp_scatter);
+    } else {
+        fprintf(stderr, "%s: unknown policy '%s' (compact, scatter or socket)\n",
+                MT_POLICY, policy);
+        exit(1);
+    }
+
+    if (*nr_cpus > topo_ncpus)
+        printf("%s: %u threads on %u cpus, cpus will be oversubscribed\n",
+               MT_POLICY, *nr_cpus, topo_ncpus);
+    for (i = 0; i < *nr_cpus; i++)
+        (*cpus)[i] = order[i % topo_ncpus].cpu;
+
+    free(order);
+}
+
+/**
+ * The cpus are taken from MT_POLICY (with MT_NTHREADS threads, or one per
+ * available cpu) if it is set, else from the explicit MT_CONF list.
+ **/
 void get_mtconf_options(unsigned int *nr_cpus, unsigned int **cpus)
 {
     unsigned int i;
     char *s,*e,*token;
 
+    e = getenv(MT_POLICY);
+    if (e) {
+        get_policy_options(e, nr_cpus, cpus);
+        return;
+    }
+
     e = getenv(MT_CONF);
     if (!e) {
         printf("%s empty: setting default mt options: 0\n", MT_CONF);
@@ -99,3 +297,29 @@ void mt_conf_print(unsigned int ncpus, unsigned int *cpus)
     }
     printf("\n");
 }
+
+/**
+ * Log where every thread runs, so that results can be related to the
+ * topology of the machine they were measured on.
+ **/
+void mt_conf_print_topology(unsigned int ncpus, unsigned int *cpus)
+{
+    unsigned int i, j;
+
+    topology_discover();
+
+    printf("MT_MAP=");
+    for (i = 0; i < ncpus; i++) {
+        for (j = 0; j < topo_ncpus; j++)
+            if (topo[j].cpu == cpus[i])
+                break;
+        if (i != 0)
+            printf(",");
+        if (j == topo_ncpus)
+            printf("%u:cpu%u", i, cpus[i]);
+        else
+            printf("%u:cpu%u/pkg%d/core%d/smt%d/node%d", i, cpus[i], topo[j].package,
+                   topo[j].core, topo[j].smt, topo[j].node);
+    }
+    printf("\n");
+}
@@ -16,6 +16,17 @@
 		} \
 	} while(0)
 
+/**
+ * Same as XMALLOC() but the returned memory is aligned to `align` bytes.
+ **/
+#define XMALLOC_ALIGNED(var,N,align) \
+	do { \
+		if (posix_memalign((void **)&(var), (align), (N) * sizeof(*(var)))) { \
+			fprintf(stderr, "Out of memory: %s:%d\n", __FILE__, __LINE__); \
+			exit(1); \
+		} \
+	} while(0)
+
 #define XFREE(var) free(var)
 
 #endif /* ALLOC_H */
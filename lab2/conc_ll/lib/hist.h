@@ -0,0 +1,97 @@
+#ifndef HIST_H
+#define HIST_H
+
+#include <string.h>
+
+/**
+ * HDR-style log-linear histogram of 64-bit values (latencies in ns).
+ * Values below HIST_SUB_BUCKETS get a bucket each; above that every power of
+ * two is split into HIST_SUB_BUCKETS linear buckets, so any recorded value is
+ * off by at most 1/HIST_SUB_BUCKETS (~3%).
+ * A histogram is only ever written by its owning thread, so recording needs
+ * no atomics. Histograms are merged once all threads are done.
+ **/
+#define HIST_SUB_BITS    5
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS     ((64 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+typedef struct {
+	unsigned long long count;
+	unsigned long long max;
+	unsigned long long buckets[HIST_BUCKETS];
+} hist_t;
+
+static inline void hist_reset(hist_t *h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+static inline int hist_bucket(unsigned long long val)
+{
+	int msb, shift;
+
+	if (val < HIST_SUB_BUCKETS)
+		return (int)val;
+
+	msb = 63 - __builtin_clzll(val);
+	shift = msb - HIST_SUB_BITS;
+	return (shift + 1) * HIST_SUB_BUCKETS + (int)((val >> shift) - HIST_SUB_BUCKETS);
+}
+
+/**
+ * Largest value that falls in bucket `b`.
+ **/
+static inline unsigned long long hist_bucket_max(int b)
+{
+	int group = b / HIST_SUB_BUCKETS, off = b % HIST_SUB_BUCKETS;
+
+	if (group == 0)
+		return (unsigned long long)b;
+	return (((unsigned long long)(HIST_SUB_BUCKETS + off + 1)) << (group - 1)) - 1;
+}
+
+static inline void hist_record(hist_t *h, unsigned long long val)
+{
+	h->buckets[hist_bucket(val)]++;
+	h->count++;
+	if (val > h->max)
+		h->max = val;
+}
+
+static inline void hist_merge(hist_t *dst, const hist_t *src)
+{
+	int i;
+
+	for (i=0; i < HIST_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+	dst->count += src->count;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+/**
+ * Value at percentile `pct` (0-100), reported as the top of its bucket.
+ **/
+static inline unsigned long long hist_percentile(const hist_t *h, double pct)
+{
+	unsigned long long seen = 0, target;
+	int i;
+
+	if (!h->count)
+		return 0;
+
+	target = (unsigned long long)(pct / 100.0 * h->count + 0.5);
+	if (target < 1)
+		target = 1;
+	for (i=0; i < HIST_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= target)
+			break;
+	}
+
+	if (hist_bucket_max(i) > h->max)
+		return h->max;
+	return hist_bucket_max(i);
+}
+
+#endif /* HIST_H */
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
 #include "alloc.h"
 
 typedef struct timer_s {
@@ -42,4 +43,15 @@ static inline double timer_report_sec(timer_tt *timer)
     return timer->duration;
 }
 
+/**
+ * Monotonic timestamp in nanoseconds, for timing individual operations.
+ **/
+static inline unsigned long long timer_now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 #endif /* TIMER_H */
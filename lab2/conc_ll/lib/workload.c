@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "alloc.h"
+#include "workload.h"
+
+#define DEFAULT_LIST_SIZE  1024
+#define DEFAULT_DURATION   10
+#define DEFAULT_STREAM_LEN (1 << 16)
+
+/* A prime: multiplying by it modulo the key range is a bijection whenever
+ * gcd(SCRAMBLE_PRIME, key_range) == 1, i.e. unless the key range is a
+ * multiple of it. Below 2^32 the only such key range is the prime itself,
+ * which workload_prepare() rejects. */
+#define SCRAMBLE_PRIME 2654435761ULL
+
+static const char *dist_names[] = { "uniform", "zipf", "hotspot", "sequential" };
+
+#define workload_error(format...) \
+	do { \
+		fprintf(stderr, format); \
+		exit(EXIT_FAILURE); \
+	} while (0)
+
+void workload_init(workload_t *w)
+{
+	memset(w, 0, sizeof(*w));
+	w->contains_pct = 100;
+	w->duration = DEFAULT_DURATION;
+	w->list_size = DEFAULT_LIST_SIZE;
+	w->dist = DIST_UNIFORM;
+	w->zipf_theta = 0.99;
+	w->hot_keys = 0.2;
+	w->hot_ops = 0.8;
+	w->stream_len = DEFAULT_STREAM_LEN;
+}
+
+static char *strip(char *s)
+{
+	char *end;
+
+	while (isspace((unsigned char)*s))
+		s++;
+	end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1]))
+		*--end = '\0';
+	return s;
+}
+
+/**
+ * Parse a distribution given as name[:param[:param]], e.g. "zipf:0.99" or
+ * "hotspot:0.2:0.8". Returns 0 on success.
+ **/
+int workload_parse_dist(workload_t *w, const char *spec)
+{
+	char buf[128], *name, *p1, *p2;
+	unsigned int i;
+
+	strncpy(buf, spec, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+	name = strtok(buf, ":");
+	p1 = strtok(NULL, ":");
+	p2 = strtok(NULL, ":");
+	if (!name)
+		return -1;
+
+	for (i=0; i < sizeof(dist_names) / sizeof(dist_names[0]); i++)
+		if (!strcmp(name, dist_names[i]))
+			break;
+	if (i == sizeof(dist_names) / sizeof(dist_names[0]))
+		return -1;
+	w->dist = (dist_t)i;
+
+	if (w->dist == DIST_ZIPF && p1)
+		w->zipf_theta = atof(p1);
+	if (w->dist == DIST_HOTSPOT && p1)
+		w->hot_keys = atof(p1);
+	if (w->dist == DIST_HOTSPOT && p2)
+		w->hot_ops = atof(p2);
+	return 0;
+}
+
+void workload_read_file(workload_t *w, const char *path)
+{
+	FILE *fp;
+	char line[256], *name, *value, *p;
+	int lineno = 0;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		workload_error("Cannot open workload file '%s'.\n", path);
+
+	while (fgets(line, sizeof(line), fp)) {
+		lineno++;
+		if ((p = strchr(line, '#')))
+			*p = '\0';
+		name = strip(line);
+		if (!*name)
+			continue;
+		if (!(p = strchr(name, '=')))
+			workload_error("%s:%d: expected 'name = value'\n", path, lineno);
+		*p = '\0';
+		name = strip(name);
+		value = strip(p + 1);
+
+		if (!strcmp(name, "mix")) {
+			if (sscanf(value, "%d/%d/%d", &w->contains_pct, &w->add_pct,
+			           &w->remove_pct) != 3)
+				workload_error("%s:%d: mix must be contains/add/remove\n", path, lineno);
+		} else if (!strcmp(name, "duration")) {
+			w->duration = atoi(value);
+		} else if (!strcmp(name, "list_size")) {
+			w->list_size = strtoul(value, NULL, 10);
+		} else if (!strcmp(name, "key_range")) {
+			w->key_range = strtoul(value, NULL, 10);
+		} else if (!strcmp(name, "distribution")) {
+			if (workload_parse_dist(w, value))
+				workload_error("%s:%d: unknown distribution '%s'\n", path, lineno, value);
+		} else if (!strcmp(name, "zipf_theta")) {
+			w->zipf_theta = atof(value);
+		} else if (!strcmp(name, "hot_keys")) {
+			w->hot_keys = atof(value);
+		} else if (!strcmp(name, "hot_ops")) {
+			w->hot_ops = atof(value);
+		} else if (!strcmp(name, "scramble")) {
+			w->scramble = atoi(value);
+		} else if (!strcmp(name, "stream_len")) {
+			w->stream_len = strtoul(value, NULL, 10);
+		} else {
+			workload_error("%s:%d: unknown setting '%s'\n", path, lineno, name);
+		}
+	}
+
+	fclose(fp);
+}
+
+/**
+ * Validate the workload and compute everything that is shared by all threads
+ * (the zipf constants, following Gray et al., "Quickly generating
+ * billion-record synthetic databases").
+ **/
+void workload_prepare(workload_t *w)
+{
+	unsigned int i, len;
+	double zeta2;
+
+	if (w->contains_pct + w->add_pct + w->remove_pct != 100)
+		workload_error("The total percentage of operations is not 100%%!\n");
+	if (!w->key_range)
+		w->key_range = w->list_size + 1;
+	if (w->scramble && w->key_range % SCRAMBLE_PRIME == 0)
+		workload_error("key_range must not be a multiple of %llu.\n", SCRAMBLE_PRIME);
+	if (w->dist == DIST_ZIPF && (w->zipf_theta <= 0.0 || w->zipf_theta >= 1.0))
+		workload_error("zipf_theta must be in (0, 1).\n");
+	if (w->dist == DIST_HOTSPOT && (w->hot_keys <= 0.0 || w->hot_keys > 1.0 ||
+	                                w->hot_ops < 0.0 || w->hot_ops > 1.0))
+		workload_error("hot_keys must be in (0, 1] and hot_ops in [0, 1].\n");
+
+	/* Round the stream up to a power of two so threads can wrap with a mask. */
+	for (len=1; len < w->stream_len; len <<= 1)
+		;
+	w->stream_len = len;
+
+	if (w->dist == DIST_ZIPF) {
+		w->zipf_zetan = 0.0;
+		for (i=1; i <= w->key_range; i++)
+			w->zipf_zetan += 1.0 / pow((double)i, w->zipf_theta);
+		zeta2 = 1.0 + 1.0 / pow(2.0, w->zipf_theta);
+		w->zipf_alpha = 1.0 / (1.0 - w->zipf_theta);
+		w->zipf_eta = (1.0 - pow(2.0 / w->key_range, 1.0 - w->zipf_theta)) /
+		              (1.0 - zeta2 / w->zipf_zetan);
+	}
+}
+
+void workload_print(const workload_t *w)
+{
+	printf("Workload: %d/%d/%d  Duration(sec): %d  ListSize: %u  KeyRange: %u"
+	       "  Distribution: %s", w->contains_pct, w->add_pct, w->remove_pct,
+	       w->duration, w->list_size, w->key_range, dist_names[w->dist]);
+	if (w->dist == DIST_ZIPF)
+		printf("  Theta: %.2lf", w->zipf_theta);
+	else if (w->dist == DIST_HOTSPOT)
+		printf("  HotKeys: %.2lf  HotOps: %.2lf", w->hot_keys, w->hot_ops);
+	if (w->scramble)
+		printf("  Scrambled");
+	printf("\n");
+}
+
+static inline double rand_double(struct drand48_data *buf)
+{
+	double res;
+
+	drand48_r(buf, &res);
+	return res;
+}
+
+static unsigned int zipf_next(const workload_t *w, struct drand48_data *buf)
+{
+	double u = rand_double(buf), uz = u * w->zipf_zetan;
+	unsigned int rank;
+
+	if (uz < 1.0)
+		return 0;
+	if (uz < 1.0 + pow(0.5, w->zipf_theta))
+		return 1;
+	rank = (unsigned int)(w->key_range * pow(w->zipf_eta * u - w->zipf_eta + 1.0,
+	                                         w->zipf_alpha));
+	return rank < w->key_range ? rank : w->key_range - 1;
+}
+
+static unsigned int hotspot_next(const workload_t *w, struct drand48_data *buf)
+{
+	unsigned int hot = (unsigned int)(w->hot_keys * w->key_range);
+
+	if (hot < 1)
+		hot = 1;
+	if (hot >= w->key_range || rand_double(buf) < w->hot_ops)
+		return (unsigned int)(rand_double(buf) * hot);
+	return hot + (unsigned int)(rand_double(buf) * (w->key_range - hot));
+}
+
+/**
+ * Precompute the operations of thread `tid` so that drawing keys does not
+ * add to the measured time. Sequential streams of different threads start
+ * at evenly spaced points of the key range.
+ **/
+void op_stream_init(op_stream_t *s, const workload_t *w, int tid, int nthreads)
+{
+	struct drand48_data drand_buffer;
+	unsigned long long key;
+	unsigned int i, seq_start;
+	int op;
+
+	srand48_r(tid * 7919 + 1, &drand_buffer);
+	s->len = w->stream_len;
+	XMALLOC(s->keys, s->len);
+	XMALLOC(s->ops, s->len);
+
+	seq_start = (unsigned int)((unsigned long long)w->key_range * tid / nthreads);
+	for (i=0; i < s->len; i++) {
+		switch (w->dist) {
+		case DIST_ZIPF:
+			key = zipf_next(w, &drand_buffer);
+			break;
+		case DIST_HOTSPOT:
+			key = hotspot_next(w, &drand_buffer);
+			break;
+		case DIST_SEQUENTIAL:
+			key = (seq_start + (unsigned long long)i) % w->key_range;
+			break;
+		default:
+			key = (unsigned int)(rand_double(&drand_buffer) * w->key_range);
+			break;
+		}
+		if (w->scramble)
+			key = key * SCRAMBLE_PRIME % w->key_range;
+		s->keys[i] = (int)key;
+
+		op = (int)(rand_double(&drand_buffer) * 100);
+		if (op < w->contains_pct)
+			s->ops[i] = 0;
+		else if (op < w->contains_pct + w->add_pct)
+			s->ops[i] = 1;
+		else
+			s->ops[i] = 2;
+	}
+}
+
+void op_stream_free(op_stream_t *s)
+{
+	XFREE(s->keys);
+	XFREE(s->ops);
+}
@@ -0,0 +1,64 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+/**
+ * Key distributions supported by the benchmark driver.
+ **/
+typedef enum {
+	DIST_UNIFORM = 0,
+	DIST_ZIPF,
+	DIST_HOTSPOT,
+	DIST_SEQUENTIAL
+} dist_t;
+
+/**
+ * A workload: operation mix, duration and how keys are drawn from the key
+ * range [0, key_range). It can be read from a spec file with lines of the
+ * form `name = value` ('#' starts a comment):
+ *
+ *   mix = 80/10/10           # contains/add/remove percentages
+ *   duration = 10            # seconds
+ *   list_size = 1024         # the list is prefilled with 1..list_size/2
+ *   key_range = 1025         # defaults to list_size + 1
+ *   distribution = zipf      # uniform, zipf, hotspot or sequential
+ *   zipf_theta = 0.99        # skew of the zipf distribution (0 < theta < 1)
+ *   hot_keys = 0.2           # hotspot: fraction of the keys that are hot
+ *   hot_ops = 0.8            # hotspot: fraction of the operations on them
+ *   scramble = 1             # spread hot keys over the range instead of
+ *                            # keeping them at its beginning
+ *   stream_len = 65536       # operations precomputed per thread
+ **/
+typedef struct {
+	int contains_pct, add_pct, remove_pct;
+	int duration;
+	unsigned int list_size;
+	unsigned int key_range;
+	dist_t dist;
+	double zipf_theta;
+	double hot_keys, hot_ops;
+	int scramble;
+	unsigned int stream_len;
+
+	/* Precomputed zipf constants, set by workload_prepare(). */
+	double zipf_zetan, zipf_alpha, zipf_eta;
+} workload_t;
+
+/**
+ * A precomputed stream of operations for a single thread.
+ **/
+typedef struct {
+	int *keys;
+	char *ops; /* 0: contains, 1: add, 2: remove */
+	unsigned int len;
+} op_stream_t;
+
+void workload_init(workload_t *w);
+void workload_read_file(workload_t *w, const char *path);
+int workload_parse_dist(workload_t *w, const char *spec);
+void workload_prepare(workload_t *w);
+void workload_print(const workload_t *w);
+
+void op_stream_init(op_stream_t *s, const workload_t *w, int tid, int nthreads);
+void op_stream_free(op_stream_t *s);
+
+#endif /* WORKLOAD_H */
@@ -16,6 +16,22 @@ int ll_contains(ll_t *ll, int key);
 int ll_add(ll_t *ll, int key);
 int ll_remove(ll_t *ll, int key);
 
+/**
+ * Batch versions of the above. `keys` must be sorted in ascending order and
+ * the whole batch is applied in a single pass over the list. They return how
+ * many keys were found/added/removed. ll_contains_batch() also stores the
+ * result for each key in `found`, unless it is NULL.
+ **/
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found);
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys);
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys);
+
+/**
+ * Number of times the calling thread had to restart an operation so far
+ * (failed validation, lost CAS etc.). Always 0 for blocking implementations.
+ **/
+unsigned long long ll_retries();
+
 /**
  * Print a linked list (only for debugging).
  **/
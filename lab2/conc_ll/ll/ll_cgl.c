@@ -127,6 +127,87 @@ int ll_remove(ll_t *ll, int key)
 	return ret;
 }
 
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	ll_node_t *curr = ll->head;
+	int i, hit, ret = 0;
+
+	pthread_spin_lock(&ll->lock);
+	for (i=0; i < nkeys; i++) {
+		while (curr->key < keys[i])
+			curr = curr->next;
+
+		hit = (keys[i] == curr->key);
+		if (found)
+			found[i] = hit;
+		ret += hit;
+	}
+	pthread_spin_unlock(&ll->lock);
+
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *curr, *next;
+	ll_node_t *new_node;
+
+	pthread_spin_lock(&ll->lock);
+	curr = ll->head;
+	next = curr->next;
+
+	for (i=0; i < nkeys; i++) {
+		while (next->key < keys[i]) {
+			curr = next;
+			next = curr->next;
+		}
+
+		if (keys[i] != next->key) {
+			ret++;
+			new_node = ll_node_new(keys[i]);
+			new_node->next = next;
+			curr->next = new_node;
+			next = new_node;
+		}
+	}
+	pthread_spin_unlock(&ll->lock);
+
+	return ret;
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *curr, *next;
+
+	pthread_spin_lock(&ll->lock);
+	curr = ll->head;
+	next = curr->next;
+
+	for (i=0; i < nkeys; i++) {
+		while (next->key < keys[i]) {
+			curr = next;
+			next = curr->next;
+		}
+
+		if (keys[i] == next->key) {
+			ret++;
+			curr->next = next->next;
+			ll_node_free(next);
+			next = curr->next;
+		}
+	}
+	pthread_spin_unlock(&ll->lock);
+
+	return ret;
+}
+
+unsigned long long ll_retries()
+{
+	return 0;
+}
+
 void ll_print(ll_t *ll)
 {
 	ll_node_t *curr = ll->head;
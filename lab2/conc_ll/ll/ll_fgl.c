@@ -138,6 +138,107 @@ int ll_remove(ll_t *ll, int key)
 	return ret;
 }
 
+/**
+ * Move the locked (curr, next) pair forward, hand-over-hand, until
+ * next->key >= k. Used by the batch operations.
+ **/
+#define TRAVERSE_LIST_LOCKED(k) \
+	do { \
+		while (next->key < (k)) { \
+			UNLOCK_NODE(curr); \
+			curr = next; \
+			LOCK_NODE(curr->next); \
+			next = curr->next; \
+		} \
+	} while (0)
+
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	int i, hit, ret = 0;
+	ll_node_t *curr, *next;
+
+	LOCK_NODE(ll->head);
+	curr = ll->head;
+	LOCK_NODE(curr->next);
+	next = curr->next;
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_LOCKED(keys[i]);
+
+		hit = (keys[i] == next->key);
+		if (found)
+			found[i] = hit;
+		ret += hit;
+	}
+
+	UNLOCK_NODE(curr);
+	UNLOCK_NODE(next);
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *curr, *next;
+	ll_node_t *new_node;
+
+	LOCK_NODE(ll->head);
+	curr = ll->head;
+	LOCK_NODE(curr->next);
+	next = curr->next;
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_LOCKED(keys[i]);
+
+		if (keys[i] != next->key) {
+			ret++;
+			new_node = ll_node_new(keys[i]);
+			new_node->next = next;
+			LOCK_NODE(new_node);
+			curr->next = new_node;
+			UNLOCK_NODE(next);
+			next = new_node;
+		}
+	}
+
+	UNLOCK_NODE(curr);
+	UNLOCK_NODE(next);
+	return ret;
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *curr, *next;
+
+	LOCK_NODE(ll->head);
+	curr = ll->head;
+	LOCK_NODE(curr->next);
+	next = curr->next;
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_LOCKED(keys[i]);
+
+		if (keys[i] == next->key) {
+			ret++;
+			LOCK_NODE(next->next);
+			curr->next = next->next;
+			UNLOCK_NODE(next);
+			ll_node_free(next);
+			next = curr->next;
+		}
+	}
+
+	UNLOCK_NODE(curr);
+	UNLOCK_NODE(next);
+	return ret;
+}
+
+unsigned long long ll_retries()
+{
+	return 0;
+}
+
 /**
  * Print a linked list.
  **/
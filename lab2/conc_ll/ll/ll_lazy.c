@@ -17,6 +17,11 @@ struct linked_list {
 	ll_node_t *head;
 };
 
+/**
+ * Per-thread number of restarted operations, see ll_retries().
+ **/
+static __thread unsigned long long nr_retries;
+
 /**
  * Create a new linked list node.
  **/
@@ -129,6 +134,7 @@ int ll_add(ll_t *ll, int key)
 		}
 		UNLOCK_NODE(curr);
 		UNLOCK_NODE(next);
+		nr_retries++;
 	} while (1);
 
 	return ret;
@@ -166,11 +172,114 @@ int ll_remove(ll_t *ll, int key)
 
 		UNLOCK_NODE(curr);
 		UNLOCK_NODE(next);
+		nr_retries++;
 	} while (1);
 
 	return ret;
 }
 
+/**
+ * The batch operations resume every traversal from the `curr` node of the
+ * previous key instead of the head. Any unmarked node with a smaller key is
+ * a valid starting point, since validate() only looks at curr and next.
+ **/
+#define TRAVERSE_LIST_FROM(start, k) \
+	do { \
+		curr = (start); \
+		next = curr->next; \
+		 \
+		while (next->key < (k)) { \
+			curr = next; \
+			next = curr->next; \
+		} \
+	} while (0)
+
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	int i, hit, ret = 0;
+	ll_node_t *curr = ll->head, *next;
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_FROM(curr->marked ? ll->head : curr, keys[i]);
+
+		hit = (next->key == keys[i] && !next->marked);
+		if (found)
+			found[i] = hit;
+		ret += hit;
+	}
+
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *hint = ll->head, *curr, *next;
+	ll_node_t *new_node;
+
+	for (i=0; i < nkeys; i++) {
+		do {
+			TRAVERSE_LIST_FROM(hint->marked ? ll->head : hint, keys[i]);
+
+			LOCK_NODE(curr);
+			LOCK_NODE(next);
+			if (validate(curr, next))
+				break;
+			UNLOCK_NODE(curr);
+			UNLOCK_NODE(next);
+			nr_retries++;
+		} while (1);
+
+		if (keys[i] != next->key) {
+			ret++;
+			new_node = ll_node_new(keys[i]);
+			new_node->next = next;
+			curr->next = new_node;
+		}
+		UNLOCK_NODE(curr);
+		UNLOCK_NODE(next);
+		hint = curr;
+	}
+
+	return ret;
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *hint = ll->head, *curr, *next;
+
+	for (i=0; i < nkeys; i++) {
+		do {
+			TRAVERSE_LIST_FROM(hint->marked ? ll->head : hint, keys[i]);
+
+			LOCK_NODE(curr);
+			LOCK_NODE(next);
+			if (validate(curr, next))
+				break;
+			UNLOCK_NODE(curr);
+			UNLOCK_NODE(next);
+			nr_retries++;
+		} while (1);
+
+		if (keys[i] == next->key) {
+			ret++;
+			next->marked = 1;
+			curr->next = next->next;
+		}
+		UNLOCK_NODE(curr);
+		UNLOCK_NODE(next);
+		hint = curr;
+	}
+
+	return ret;
+}
+
+unsigned long long ll_retries()
+{
+	return nr_retries;
+}
+
 /**
  * Print a linked list.
  **/
@@ -17,6 +17,11 @@ struct linked_list {
 	ll_node_t *head;
 };
 
+/**
+ * Per-thread number of restarted operations, see ll_retries().
+ **/
+static __thread unsigned long long nr_retries;
+
 /**
  * Create a new linked list node.
  **/
@@ -91,21 +96,30 @@ static inline int physical_delete_right(ll_node_t *l, ll_node_t *r)
 	return (cas_result == r);
 }
 
-static inline ll_node_t *list_search(ll_t *ll, int key, ll_node_t **left)
+/**
+ * Search for `key` starting from `start`, which must have a smaller key.
+ * If `start` has been deleted we fall back to the head of the list.
+ **/
+static inline ll_node_t *list_search_from(ll_t *ll, ll_node_t *start, int key,
+                                          ll_node_t **left)
 {
 	ll_node_t *l, *r; /* left, right */
 
 retry:
-	l = ll->head;
-	r = ll->head->next;
+	l = is_marked_reference(start->next) ? ll->head : start;
+	r = get_unmarked_reference(l->next);
 
 	while (1) {
-		if (l->next != r)
+		if (l->next != r) {
+			nr_retries++;
 			goto retry;
+		}
 
 		if (is_marked_reference(r->next)) {
-			if (!physical_delete_right(l, r))
+			if (!physical_delete_right(l, r)) {
+				nr_retries++;
 				goto retry;
+			}
 		} else {
 			if (r->key >= key)
 				break;
@@ -118,6 +132,11 @@ retry:
 	return r;
 }
 
+static inline ll_node_t *list_search(ll_t *ll, int key, ll_node_t **left)
+{
+	return list_search_from(ll, ll->head, key, left);
+}
+
 int ll_contains(ll_t *ll, int key)
 {
 	int ret = 0;
@@ -142,6 +161,8 @@ int ll_add(ll_t *ll, int key)
 		new_node = ll_node_new(key);
 		new_node->next = r;
 		cas_result = CAS_VAL(&l->next, r, new_node);
+		if (cas_result != r)
+			nr_retries++;
 	} while (cas_result != r);
 
 	return 1;
@@ -160,8 +181,95 @@ int ll_remove(ll_t *ll, int key)
 		unmarked_ref = get_unmarked_reference(r->next);
 		marked_ref = get_marked_reference(unmarked_ref);
 		cas_result = CAS_VAL(&r->next, unmarked_ref, marked_ref);
+		if (cas_result != unmarked_ref)
+			nr_retries++;
 	} while (cas_result != unmarked_ref);
 
 	physical_delete_right(l, r);
 	return 1;
 }
+
+/**
+ * The batch operations resume every search from the left node of the
+ * previous key.
+ **/
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	int i, hit, ret = 0;
+	ll_node_t *l = ll->head, *r;
+
+	for (i=0; i < nkeys; i++) {
+		r = list_search_from(ll, l, keys[i], &l);
+
+		hit = (r->key == keys[i] && !is_marked_reference(r->next));
+		if (found)
+			found[i] = hit;
+		ret += hit;
+	}
+
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *l = ll->head, *r, *cas_result;
+	ll_node_t *new_node = NULL;
+
+	for (i=0; i < nkeys; i++) {
+		do {
+			r = list_search_from(ll, l, keys[i], &l);
+			if (r->key == keys[i])
+				break;
+			if (!new_node)
+				new_node = ll_node_new(keys[i]);
+			new_node->key = keys[i];
+			new_node->next = r;
+			cas_result = CAS_VAL(&l->next, r, new_node);
+			if (cas_result != r)
+				nr_retries++;
+		} while (cas_result != r);
+
+		if (r->key != keys[i]) {
+			ret++;
+			new_node = NULL;
+		}
+	}
+
+	if (new_node)
+		ll_node_free(new_node);
+	return ret;
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *l = ll->head, *r, *cas_result;
+	void *unmarked_ref, *marked_ref;
+
+	for (i=0; i < nkeys; i++) {
+		do {
+			r = list_search_from(ll, l, keys[i], &l);
+			if (r->key != keys[i])
+				break;
+
+			unmarked_ref = get_unmarked_reference(r->next);
+			marked_ref = get_marked_reference(unmarked_ref);
+			cas_result = CAS_VAL(&r->next, unmarked_ref, marked_ref);
+			if (cas_result != unmarked_ref)
+				nr_retries++;
+		} while (cas_result != unmarked_ref);
+
+		if (r->key == keys[i]) {
+			ret++;
+			physical_delete_right(l, r);
+		}
+	}
+
+	return ret;
+}
+
+unsigned long long ll_retries()
+{
+	return nr_retries;
+}
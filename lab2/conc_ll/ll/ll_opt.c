@@ -16,6 +16,11 @@ struct linked_list {
 	ll_node_t *head;
 };
 
+/**
+ * Per-thread number of restarted operations, see ll_retries().
+ **/
+static __thread unsigned long long nr_retries;
+
 /**
  * Create a new linked list node.
  **/
@@ -114,6 +119,7 @@ int ll_contains(ll_t *ll, int key)
 		}
 		UNLOCK_NODE(curr);
 		UNLOCK_NODE(next);
+		nr_retries++;
 	} while (1);
 
 	return ret;
@@ -150,6 +156,7 @@ int ll_add(ll_t *ll, int key)
 		}
 		UNLOCK_NODE(curr);
 		UNLOCK_NODE(next);
+		nr_retries++;
 	} while (1);
 
 	return ret;
@@ -186,11 +193,134 @@ int ll_remove(ll_t *ll, int key)
 
 		UNLOCK_NODE(curr);
 		UNLOCK_NODE(next);
+		nr_retries++;
 	} while (1);
 
 	return ret;
 }
 
+/**
+ * Lock and validate the (curr, next) pair for `key`, like ll_add() does.
+ **/
+static void lock_position(ll_t *ll, int key, ll_node_t **currp, ll_node_t **nextp)
+{
+	ll_node_t *curr, *next;
+
+	do {
+		TRAVERSE_LIST();
+
+		LOCK_NODE(curr);
+		LOCK_NODE(next);
+		if (validate(ll, curr, next))
+			break;
+		UNLOCK_NODE(curr);
+		UNLOCK_NODE(next);
+		nr_retries++;
+	} while (1);
+
+	*currp = curr;
+	*nextp = next;
+}
+
+/**
+ * The batch operations find the position of the first key optimistically and
+ * then keep the (curr, next) pair locked, moving it forward hand-over-hand.
+ * A locked node cannot be unlinked, so the pair never needs revalidation.
+ **/
+#define TRAVERSE_LIST_LOCKED(k) \
+	do { \
+		while (next->key < (k)) { \
+			UNLOCK_NODE(curr); \
+			curr = next; \
+			LOCK_NODE(curr->next); \
+			next = curr->next; \
+		} \
+	} while (0)
+
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	int i, hit, ret = 0;
+	ll_node_t *curr, *next;
+
+	if (nkeys <= 0)
+		return 0;
+	lock_position(ll, keys[0], &curr, &next);
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_LOCKED(keys[i]);
+
+		hit = (keys[i] == next->key);
+		if (found)
+			found[i] = hit;
+		ret += hit;
+	}
+
+	UNLOCK_NODE(curr);
+	UNLOCK_NODE(next);
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *curr, *next;
+	ll_node_t *new_node;
+
+	if (nkeys <= 0)
+		return 0;
+	lock_position(ll, keys[0], &curr, &next);
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_LOCKED(keys[i]);
+
+		if (keys[i] != next->key) {
+			ret++;
+			new_node = ll_node_new(keys[i]);
+			new_node->next = next;
+			LOCK_NODE(new_node);
+			curr->next = new_node;
+			UNLOCK_NODE(next);
+			next = new_node;
+		}
+	}
+
+	UNLOCK_NODE(curr);
+	UNLOCK_NODE(next);
+	return ret;
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	int i, ret = 0;
+	ll_node_t *curr, *next;
+
+	if (nkeys <= 0)
+		return 0;
+	lock_position(ll, keys[0], &curr, &next);
+
+	for (i=0; i < nkeys; i++) {
+		TRAVERSE_LIST_LOCKED(keys[i]);
+
+		if (keys[i] == next->key) {
+			ret++;
+			LOCK_NODE(next->next);
+			curr->next = next->next;
+			UNLOCK_NODE(next);
+//			ll_node_free(next);
+			next = curr->next;
+		}
+	}
+
+	UNLOCK_NODE(curr);
+	UNLOCK_NODE(next);
+	return ret;
+}
+
+unsigned long long ll_retries()
+{
+	return nr_retries;
+}
+
 /**
  * Print a linked list.
  **/
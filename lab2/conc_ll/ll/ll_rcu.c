@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h> /* qsort() */
+#include <string.h> /* memcpy() */
+
+#include "../lib/alloc.h"
+#include "ll.h"
+
+#define CACHE_LINE_SIZE 64
+
+#define CAS_BOOL(addr, old_val, new_val) \
+	__sync_bool_compare_and_swap((addr), (old_val), (new_val))
+
+/**
+ * RCU-style snapshot set. The set is an immutable sorted array (a snapshot)
+ * that readers binary-search after a plain load of the current snapshot
+ * pointer. Writers never modify a published snapshot: they build a new one
+ * with their updates applied, publish it and retire the old one.
+ *
+ * Writers are batched with flat combining: a writer posts its update in its
+ * per-thread record and whoever gets the writer lock applies all the posted
+ * updates with a single copy of the array.
+ *
+ * Retired snapshots are reclaimed after a grace period, QSBR style. The list
+ * keeps a grace period counter `gp` that writers bump after every publish,
+ * and every thread stores the value it saw in its record (`qs`) at the end of
+ * each operation, when it holds no references to any snapshot. A snapshot
+ * retired at gp == G may be freed once every registered thread has qs >= G.
+ * Readers thus only do plain loads and a store to their own cache line: no
+ * atomic instructions and no fences on x86. Reclamation never blocks, it is
+ * attempted by every writer batch, but a thread that stops calling into the
+ * list holds back reclamation of everything retired after its last
+ * operation until ll_free().
+ **/
+typedef struct snapshot {
+	unsigned long long retired_at; /* gp value when it was replaced. */
+	struct snapshot *next_retired;
+	int count;
+	int keys[];
+} snapshot_t;
+
+enum { REQ_ADD = 0, REQ_REMOVE };
+
+/**
+ * Per-thread (and per-list) record, registered the first time a thread
+ * uses the list.
+ **/
+typedef struct rcu_thread {
+	volatile unsigned long long qs;
+	/* Posted update, see ll_update(). */
+	int key;
+	int op;
+	int result;
+	volatile int pending;
+	void *owner;
+	struct rcu_thread *next;
+} __attribute__ ((aligned(CACHE_LINE_SIZE))) rcu_thread_t;
+
+typedef struct {
+	int key;
+	int op;
+	int *result;
+	rcu_thread_t *rec; /* Whose posted update this is, NULL for batches. */
+} rcu_req_t;
+
+struct linked_list {
+	/* Read by everyone, written only by the combiner. */
+	snapshot_t *snap;
+	volatile unsigned long long gp;
+	char padding1[CACHE_LINE_SIZE - sizeof(snapshot_t *) - sizeof(unsigned long long)];
+
+	volatile int wlock;
+	char padding2[CACHE_LINE_SIZE - sizeof(int)];
+
+	rcu_thread_t *volatile threads;
+	unsigned long id;
+
+	/* Only touched while holding wlock. */
+	snapshot_t *retired; /* Newest first. */
+	rcu_req_t *reqs;
+	int reqs_size;
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * The address of myIdentity tells threads apart. The record of the last list
+ * we used is cached, keyed by a unique list id rather than its address, which
+ * could be reused after ll_free().
+ **/
+static unsigned long nr_lists;
+static __thread char myIdentity;
+static __thread unsigned long myListId;
+static __thread rcu_thread_t *myRecord;
+
+static snapshot_t *snapshot_new(int max_keys)
+{
+	snapshot_t *ret;
+
+	ret = malloc(sizeof(*ret) + max_keys * sizeof(int));
+	if (!ret) {
+		fprintf(stderr, "Out of memory: %s:%d\n", __FILE__, __LINE__);
+		exit(1);
+	}
+	ret->retired_at = 0;
+	ret->next_retired = NULL;
+	ret->count = 0;
+
+	return ret;
+}
+
+static void snapshot_free(snapshot_t *snap)
+{
+	XFREE(snap);
+}
+
+/**
+ * Return the position of the first key in `snap` that is >= `key`.
+ **/
+static inline int snapshot_lower_bound(const snapshot_t *snap, int key)
+{
+	int lo = 0, hi = snap->count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (snap->keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static inline int snapshot_has_key(const snapshot_t *snap, int key)
+{
+	int i = snapshot_lower_bound(snap, key);
+	return (i < snap->count && snap->keys[i] == key);
+}
+
+/**
+ * Create a new empty linked list.
+ **/
+ll_t *ll_new()
+{
+	ll_t *ret;
+
+	XMALLOC_ALIGNED(ret, 1, CACHE_LINE_SIZE);
+	ret->snap = snapshot_new(0);
+	ret->gp = 1;
+	ret->wlock = 0;
+	ret->threads = NULL;
+	ret->id = __sync_add_and_fetch(&nr_lists, 1);
+	ret->retired = NULL;
+	ret->reqs = NULL;
+	ret->reqs_size = 0;
+
+	return ret;
+}
+
+/**
+ * Free a linked list, its snapshots and the thread records.
+ **/
+void ll_free(ll_t *ll)
+{
+	snapshot_t *snap, *next_snap;
+	rcu_thread_t *rec, *next_rec;
+
+	for (snap = ll->retired; snap; snap = next_snap) {
+		next_snap = snap->next_retired;
+		snapshot_free(snap);
+	}
+	snapshot_free(ll->snap);
+	for (rec = ll->threads; rec; rec = next_rec) {
+		next_rec = rec->next;
+		XFREE(rec);
+	}
+	XFREE(ll->reqs);
+	XFREE(ll);
+}
+
+/**
+ * Find (or register) the record of the calling thread.
+ **/
+static rcu_thread_t *rcu_thread(ll_t *ll)
+{
+	rcu_thread_t *rec;
+
+	if (myListId == ll->id)
+		return myRecord;
+
+	for (rec = ll->threads; rec; rec = rec->next)
+		if (rec->owner == &myIdentity)
+			goto found;
+
+	XMALLOC_ALIGNED(rec, 1, CACHE_LINE_SIZE);
+	rec->qs = ll->gp;
+	rec->pending = 0;
+	rec->owner = &myIdentity;
+	do {
+		rec->next = ll->threads;
+	} while (!CAS_BOOL(&ll->threads, rec->next, rec));
+
+found:
+	myListId = ll->id;
+	myRecord = rec;
+	return rec;
+}
+
+/**
+ * Announce a quiescent state: we hold no snapshot references anymore.
+ **/
+static inline void rcu_quiescent(ll_t *ll, rcu_thread_t *me)
+{
+	__atomic_store_n(&me->qs, __atomic_load_n(&ll->gp, __ATOMIC_ACQUIRE),
+	                 __ATOMIC_RELEASE);
+}
+
+static inline snapshot_t *rcu_dereference(ll_t *ll)
+{
+	return __atomic_load_n(&ll->snap, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Free the retired snapshots whose grace period has elapsed. Called with
+ * wlock held.
+ **/
+static void rcu_reclaim(ll_t *ll)
+{
+	unsigned long long min_qs = ~0ULL;
+	snapshot_t **pprev, *snap, *next;
+	rcu_thread_t *rec;
+
+	for (rec = ll->threads; rec; rec = rec->next)
+		if (rec->qs < min_qs)
+			min_qs = rec->qs;
+
+	/* The list is sorted newest first, so everything after the first
+	 * reclaimable snapshot is reclaimable too. */
+	for (pprev = &ll->retired; *pprev; pprev = &(*pprev)->next_retired)
+		if ((*pprev)->retired_at <= min_qs)
+			break;
+	for (snap = *pprev; snap; snap = next) {
+		next = snap->next_retired;
+		snapshot_free(snap);
+	}
+	*pprev = NULL;
+}
+
+static int req_cmp(const void *a, const void *b)
+{
+	int ka = ((const rcu_req_t *)a)->key, kb = ((const rcu_req_t *)b)->key;
+	return (ka > kb) - (ka < kb);
+}
+
+/**
+ * Apply `n` updates, sorted by key, on top of the current snapshot and
+ * publish the result. Updates on the same key take effect in the order they
+ * appear. Called with wlock held.
+ **/
+static void ll_publish(ll_t *ll, rcu_req_t *reqs, int n)
+{
+	snapshot_t *old = ll->snap, *new;
+	int i = 0, r = 0, out = 0, key, present, changed = 0;
+
+	new = snapshot_new(old->count + n);
+	while (r < n) {
+		key = reqs[r].key;
+		while (i < old->count && old->keys[i] < key)
+			new->keys[out++] = old->keys[i++];
+		present = (i < old->count && old->keys[i] == key);
+		if (present)
+			i++;
+
+		for (; r < n && reqs[r].key == key; r++) {
+			if (reqs[r].op == REQ_ADD) {
+				*reqs[r].result = !present;
+				present = 1;
+			} else {
+				*reqs[r].result = present;
+				present = 0;
+			}
+			changed += *reqs[r].result;
+		}
+		if (present)
+			new->keys[out++] = key;
+	}
+	memcpy(&new->keys[out], &old->keys[i], (old->count - i) * sizeof(int));
+	new->count = out + old->count - i;
+
+	if (!changed) {
+		snapshot_free(new);
+		return;
+	}
+
+	__atomic_store_n(&ll->snap, new, __ATOMIC_RELEASE);
+	old->retired_at = __sync_add_and_fetch(&ll->gp, 1);
+	old->next_retired = ll->retired;
+	ll->retired = old;
+	rcu_reclaim(ll);
+}
+
+static void ll_reqs_reserve(ll_t *ll, int n)
+{
+	if (n <= ll->reqs_size)
+		return;
+	XFREE(ll->reqs);
+	XMALLOC(ll->reqs, n);
+	ll->reqs_size = n;
+}
+
+/**
+ * Apply all posted updates in a single batch. Called with wlock held.
+ **/
+static void ll_combine(ll_t *ll)
+{
+	rcu_thread_t *rec;
+	int i, n = 0, nthreads = 0;
+
+	for (rec = ll->threads; rec; rec = rec->next)
+		nthreads++;
+	ll_reqs_reserve(ll, nthreads);
+
+	for (rec = ll->threads; rec && n < nthreads; rec = rec->next) {
+		if (!__atomic_load_n(&rec->pending, __ATOMIC_ACQUIRE))
+			continue;
+		ll->reqs[n].key = rec->key;
+		ll->reqs[n].op = rec->op;
+		ll->reqs[n].result = &rec->result;
+		ll->reqs[n].rec = rec;
+		n++;
+	}
+
+	qsort(ll->reqs, n, sizeof(*ll->reqs), req_cmp);
+	ll_publish(ll, ll->reqs, n);
+
+	/* Only the updates we have seen, others may have been posted since. */
+	for (i=0; i < n; i++)
+		__atomic_store_n(&ll->reqs[i].rec->pending, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Post an update and wait until it has been applied, either by the current
+ * combiner or by ourselves.
+ **/
+static int ll_update(ll_t *ll, int key, int op)
+{
+	rcu_thread_t *me = rcu_thread(ll);
+	int ret;
+
+	me->key = key;
+	me->op = op;
+	__atomic_store_n(&me->pending, 1, __ATOMIC_RELEASE);
+
+	while (1) {
+		if (!ll->wlock && CAS_BOOL(&ll->wlock, 0, 1)) {
+			ll_combine(ll);
+			__atomic_store_n(&ll->wlock, 0, __ATOMIC_RELEASE);
+			break;
+		}
+		while (__atomic_load_n(&me->pending, __ATOMIC_ACQUIRE) && ll->wlock)
+			/* do nothing */ ;
+		if (!__atomic_load_n(&me->pending, __ATOMIC_ACQUIRE))
+			break;
+	}
+
+	ret = me->result;
+	rcu_quiescent(ll, me);
+	return ret;
+}
+
+int ll_contains(ll_t *ll, int key)
+{
+	rcu_thread_t *me = rcu_thread(ll);
+	int ret;
+
+	ret = snapshot_has_key(rcu_dereference(ll), key);
+	rcu_quiescent(ll, me);
+	return ret;
+}
+
+int ll_add(ll_t *ll, int key)
+{
+	return ll_update(ll, key, REQ_ADD);
+}
+
+int ll_remove(ll_t *ll, int key)
+{
+	return ll_update(ll, key, REQ_REMOVE);
+}
+
+/**
+ * The batch operations search a single snapshot, or publish a single new one.
+ **/
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	rcu_thread_t *me = rcu_thread(ll);
+	snapshot_t *snap = rcu_dereference(ll);
+	int i, hit, ret = 0;
+
+	for (i=0; i < nkeys; i++) {
+		hit = snapshot_has_key(snap, keys[i]);
+		if (found)
+			found[i] = hit;
+		ret += hit;
+	}
+
+	rcu_quiescent(ll, me);
+	return ret;
+}
+
+/**
+ * Batch updates do everything under wlock and hold no snapshot reference
+ * afterwards, so unlike the other operations they do not register the
+ * calling thread. That way the thread that prefills the list does not hold
+ * back reclamation for the rest of the run.
+ **/
+static int ll_update_batch(ll_t *ll, const int *keys, int nkeys, int op)
+{
+	int *results;
+	int i, ret = 0;
+
+	XMALLOC(results, nkeys);
+	while (!CAS_BOOL(&ll->wlock, 0, 1))
+		/* do nothing */ ;
+
+	ll_reqs_reserve(ll, nkeys);
+	for (i=0; i < nkeys; i++) {
+		ll->reqs[i].key = keys[i];
+		ll->reqs[i].op = op;
+		ll->reqs[i].result = &results[i];
+		ll->reqs[i].rec = NULL;
+	}
+	ll_publish(ll, ll->reqs, nkeys);
+
+	__atomic_store_n(&ll->wlock, 0, __ATOMIC_RELEASE);
+
+	for (i=0; i < nkeys; i++)
+		ret += results[i];
+	XFREE(results);
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	return ll_update_batch(ll, keys, nkeys, REQ_ADD);
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	return ll_update_batch(ll, keys, nkeys, REQ_REMOVE);
+}
+
+/**
+ * Readers never restart and writers wait for the combiner instead.
+ **/
+unsigned long long ll_retries()
+{
+	return 0;
+}
+
+/**
+ * Print a linked list.
+ **/
+void ll_print(ll_t *ll)
+{
+	snapshot_t *snap = ll->snap;
+	int i;
+
+	printf("LIST [");
+	for (i=0; i < snap->count; i++)
+		printf(" -> %d", snap->keys[i]);
+	printf(" ]\n");
+}
@@ -0,0 +1,460 @@
+#include <stdio.h>
+#include <stdlib.h> /* rand() */
+#include <string.h> /* memcpy(), memmove() */
+#include <limits.h>
+
+#include "../lib/alloc.h"
+#include "ll.h"
+
+#define CACHE_LINE_SIZE 64
+
+/**
+ * Every node occupies exactly one cache line. Besides the sorted keys it
+ * stores a version word (which doubles as the node's lock), the number of
+ * keys and the smallest key the node is responsible for (`low`). A node is
+ * responsible for all keys in [node->low, node->next->low).
+ **/
+#define NODE_KEYS ((int)((CACHE_LINE_SIZE - 3*sizeof(int) - sizeof(void *)) / sizeof(int)))
+#define NODE_MIN_KEYS (NODE_KEYS / 4)
+
+/**
+ * Version word: bit 0 is the lock, bit 1 marks a node that has been removed
+ * from the list and the remaining bits count modifications.
+ **/
+#define V_LOCKED 0x1U
+#define V_DEAD   0x2U
+#define V_INC    0x4U
+
+#define CAS_BOOL(addr, old_val, new_val) \
+	__sync_bool_compare_and_swap((addr), (old_val), (new_val))
+#define READ_ONCE(x) (*(volatile __typeof__(x) *)&(x))
+
+typedef struct ll_node {
+	unsigned int version;
+	int count;
+	int low;
+	int keys[NODE_KEYS];
+	struct ll_node *next;
+} __attribute__ ((aligned(CACHE_LINE_SIZE))) ll_node_t;
+
+struct linked_list {
+	ll_node_t *head;
+};
+
+/**
+ * Per-thread number of restarted operations, see ll_retries().
+ **/
+static __thread unsigned long long nr_retries;
+
+/**
+ * Create a new (empty) linked list node.
+ **/
+static ll_node_t *ll_node_new(int low)
+{
+	ll_node_t *ret;
+
+	XMALLOC_ALIGNED(ret, 1, CACHE_LINE_SIZE);
+	ret->version = 0;
+	ret->count = 0;
+	ret->low = low;
+	ret->next = NULL;
+
+	return ret;
+}
+
+/**
+ * Free a linked list node.
+ **/
+static void ll_node_free(ll_node_t *ll_node)
+{
+	XFREE(ll_node);
+}
+
+/**
+ * Create a new empty linked list.
+ **/
+ll_t *ll_new()
+{
+	ll_t *ret;
+
+	XMALLOC(ret, 1);
+	ret->head = ll_node_new(INT_MIN);
+
+	return ret;
+}
+
+/**
+ * Free a linked list and all its contained nodes.
+ **/
+void ll_free(ll_t *ll)
+{
+	ll_node_t *next, *curr = ll->head;
+	while (curr) {
+		next = curr->next;
+		ll_node_free(curr);
+		curr = next;
+	}
+	XFREE(ll);
+}
+
+/**
+ * Optimistic reads: wait until the node is unlocked and return its version,
+ * then check that the version has not changed after reading the node.
+ **/
+static inline unsigned int node_read_begin(ll_node_t *node)
+{
+	unsigned int v;
+
+	while ((v = __atomic_load_n(&node->version, __ATOMIC_ACQUIRE)) & V_LOCKED)
+		/* do nothing */ ;
+	return v;
+}
+
+static inline int node_read_validate(ll_node_t *node, unsigned int v)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return (READ_ONCE(node->version) == v);
+}
+
+/**
+ * Lock a node only if it is still at version `v`.
+ **/
+static inline int node_trylock(ll_node_t *node, unsigned int v)
+{
+	return CAS_BOOL(&node->version, v, v | V_LOCKED);
+}
+
+static inline unsigned int node_lock(ll_node_t *node)
+{
+	unsigned int v;
+
+	do {
+		v = node_read_begin(node);
+	} while (!node_trylock(node, v));
+	return v;
+}
+
+static inline void node_unlock(ll_node_t *node, unsigned int v)
+{
+	__atomic_store_n(&node->version, v, __ATOMIC_RELEASE);
+}
+
+/**
+ * Return the position of the first key in `node` that is >= `key`.
+ **/
+static inline int node_lower_bound(ll_node_t *node, int key)
+{
+	int i, count = READ_ONCE(node->count);
+
+	if (count > NODE_KEYS)
+		count = NODE_KEYS;
+	for (i=0; i < count; i++)
+		if (node->keys[i] >= key)
+			break;
+	return i;
+}
+
+static inline int node_has_key(ll_node_t *node, int key)
+{
+	int i = node_lower_bound(node, key);
+	return (i < node->count && node->keys[i] == key);
+}
+
+/**
+ * Find the node responsible for `key` without taking any locks and return
+ * it along with the version it had when we reached it. The caller has to
+ * validate that version (or lock the node with it) before trusting the result.
+ * The search starts from `start`, which must have start->low <= key; if it
+ * has been removed from the list we start over from the head.
+ **/
+static ll_node_t *ll_find(ll_t *ll, ll_node_t *start, int key, unsigned int *version)
+{
+	ll_node_t *curr, *next;
+	unsigned int v;
+
+retry:
+	curr = start;
+	v = node_read_begin(curr);
+	if (v & V_DEAD) {
+		nr_retries++;
+		start = ll->head;
+		goto retry;
+	}
+
+	while (1) {
+		next = READ_ONCE(curr->next);
+		if (!next || next->low > key)
+			break;
+		if (!node_read_validate(curr, v)) {
+			nr_retries++;
+			goto retry;
+		}
+		curr = next;
+		v = node_read_begin(curr);
+		if (v & V_DEAD) {
+			nr_retries++;
+			start = ll->head;
+			goto retry;
+		}
+	}
+
+	*version = v;
+	return curr;
+}
+
+/**
+ * Find the node responsible for `key` and lock it.
+ **/
+static ll_node_t *ll_find_lock(ll_t *ll, ll_node_t *start, int key, unsigned int *version)
+{
+	ll_node_t *curr;
+
+	while (1) {
+		curr = ll_find(ll, start, key, version);
+		if (node_trylock(curr, *version))
+			return curr;
+		nr_retries++;
+		start = curr;
+	}
+}
+
+/**
+ * Insert `key` at position `pos` of a full (and locked) node by splitting it
+ * in two. The new node is published only after it has been fully built.
+ **/
+static void node_split_insert(ll_node_t *node, int pos, int key)
+{
+	int tmp[NODE_KEYS + 1];
+	int half = (NODE_KEYS + 1) / 2;
+	ll_node_t *new_node;
+
+	memcpy(tmp, node->keys, pos * sizeof(int));
+	tmp[pos] = key;
+	memcpy(&tmp[pos+1], &node->keys[pos], (NODE_KEYS - pos) * sizeof(int));
+
+	new_node = ll_node_new(tmp[half]);
+	new_node->count = NODE_KEYS + 1 - half;
+	memcpy(new_node->keys, &tmp[half], new_node->count * sizeof(int));
+	new_node->next = node->next;
+
+	memcpy(node->keys, tmp, half * sizeof(int));
+	node->count = half;
+	__atomic_store_n(&node->next, new_node, __ATOMIC_RELEASE);
+}
+
+/**
+ * Refill an underfull (and locked) node from its successor. If both fit in a
+ * single node the successor is absorbed, otherwise keys are borrowed from it.
+ * Borrowing changes the successor's `low`, so it is replaced by a new node.
+ * Nodes are always locked left to right, so this cannot deadlock.
+ **/
+static void node_merge(ll_node_t *node)
+{
+	ll_node_t *next = node->next, *repl;
+	unsigned int nv = node_lock(next);
+	int total = node->count + next->count;
+	int move;
+
+	if (total <= NODE_KEYS) {
+		memcpy(&node->keys[node->count], next->keys, next->count * sizeof(int));
+		node->count = total;
+		__atomic_store_n(&node->next, next->next, __ATOMIC_RELEASE);
+	} else {
+		move = total / 2 - node->count;
+		repl = ll_node_new(next->keys[move]);
+		repl->count = next->count - move;
+		memcpy(repl->keys, &next->keys[move], repl->count * sizeof(int));
+		repl->next = next->next;
+
+		memcpy(&node->keys[node->count], next->keys, move * sizeof(int));
+		node->count += move;
+		__atomic_store_n(&node->next, repl, __ATOMIC_RELEASE);
+	}
+
+	/* Concurrent readers may still be looking at it, so it is not freed. */
+	node_unlock(next, (nv + V_INC) | V_DEAD);
+//	ll_node_free(next);
+}
+
+/**
+ * Insert or delete a key from a locked node. Both return 1 if the node was
+ * modified.
+ **/
+static int node_insert(ll_node_t *node, int key)
+{
+	int pos = node_lower_bound(node, key);
+
+	if (pos < node->count && node->keys[pos] == key)
+		return 0;
+
+	if (node->count == NODE_KEYS) {
+		node_split_insert(node, pos, key);
+	} else {
+		memmove(&node->keys[pos+1], &node->keys[pos],
+		        (node->count - pos) * sizeof(int));
+		node->keys[pos] = key;
+		node->count++;
+	}
+	return 1;
+}
+
+static int node_delete(ll_node_t *node, int key)
+{
+	int pos = node_lower_bound(node, key);
+
+	if (pos == node->count || node->keys[pos] != key)
+		return 0;
+
+	memmove(&node->keys[pos], &node->keys[pos+1],
+	        (node->count - pos - 1) * sizeof(int));
+	node->count--;
+
+	if (node->count < NODE_MIN_KEYS && node->next)
+		node_merge(node);
+	return 1;
+}
+
+int ll_contains(ll_t *ll, int key)
+{
+	ll_node_t *curr;
+	unsigned int v;
+	int ret;
+
+	while (1) {
+		curr = ll_find(ll, ll->head, key, &v);
+		ret = node_has_key(curr, key);
+		if (node_read_validate(curr, v))
+			break;
+		nr_retries++;
+	}
+
+	return ret;
+}
+
+int ll_add(ll_t *ll, int key)
+{
+	ll_node_t *curr;
+	unsigned int v;
+	int ret;
+
+	curr = ll_find_lock(ll, ll->head, key, &v);
+
+	ret = node_insert(curr, key);
+	node_unlock(curr, ret ? v + V_INC : v);
+	return ret;
+}
+
+int ll_remove(ll_t *ll, int key)
+{
+	ll_node_t *curr;
+	unsigned int v;
+	int ret;
+
+	curr = ll_find_lock(ll, ll->head, key, &v);
+
+	ret = node_delete(curr, key);
+	node_unlock(curr, ret ? v + V_INC : v);
+	return ret;
+}
+
+/**
+ * The batch operations visit (or lock) each node once and handle all the
+ * keys that fall in its range before moving on to the next one.
+ **/
+#define IN_RANGE(node, k) (!(node)->next || (k) < (node)->next->low)
+
+int ll_contains_batch(ll_t *ll, const int *keys, int nkeys, int *found)
+{
+	ll_node_t *curr = ll->head;
+	unsigned int v;
+	int i = 0, j, hit, hits, ret = 0;
+
+	while (i < nkeys) {
+		curr = ll_find(ll, curr, keys[i], &v);
+
+		hits = 0;
+		j = i;
+		do {
+			hit = node_has_key(curr, keys[j]);
+			if (found)
+				found[j] = hit;
+			hits += hit;
+			j++;
+		} while (j < nkeys && IN_RANGE(curr, keys[j]));
+
+		if (!node_read_validate(curr, v)) {
+			nr_retries++;
+			continue;
+		}
+		ret += hits;
+		i = j;
+	}
+
+	return ret;
+}
+
+int ll_add_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	ll_node_t *curr = ll->head;
+	unsigned int v;
+	int i = 0, n, ret = 0;
+
+	while (i < nkeys) {
+		curr = ll_find_lock(ll, curr, keys[i], &v);
+
+		n = 0;
+		do {
+			n += node_insert(curr, keys[i++]);
+		} while (i < nkeys && IN_RANGE(curr, keys[i]));
+
+		node_unlock(curr, n ? v + V_INC : v);
+		ret += n;
+	}
+
+	return ret;
+}
+
+int ll_remove_batch(ll_t *ll, const int *keys, int nkeys)
+{
+	ll_node_t *curr = ll->head;
+	unsigned int v;
+	int i = 0, n, ret = 0;
+
+	while (i < nkeys) {
+		curr = ll_find_lock(ll, curr, keys[i], &v);
+
+		n = 0;
+		do {
+			n += node_delete(curr, keys[i++]);
+		} while (i < nkeys && IN_RANGE(curr, keys[i]));
+
+		node_unlock(curr, n ? v + V_INC : v);
+		ret += n;
+	}
+
+	return ret;
+}
+
+unsigned long long ll_retries()
+{
+	return nr_retries;
+}
+
+/**
+ * Print a linked list.
+ **/
+void ll_print(ll_t *ll)
+{
+	ll_node_t *curr = ll->head;
+	int i;
+
+	printf("LIST [");
+	while (curr) {
+		printf(" -> [");
+		for (i=0; i < curr->count; i++)
+			printf(i ? " %d" : "%d", curr->keys[i]);
+		printf("]");
+		curr = curr->next;
+	}
+	printf(" ]\n");
+}
@@ -4,11 +4,12 @@
 #include <unistd.h>
 
 #include "lib/aff.h"
+#include "lib/hist.h"
 #include "lib/timer.h"
+#include "lib/workload.h"
 #include "ll/ll.h"
 
 #define MAX_THREADS 128
-#define RUNTIME 10
 
 #define print_error_and_exit(format...) \
 	do { \
@@ -16,14 +17,23 @@
 		exit(EXIT_FAILURE); \
 	} while (0)
 
+/**
+ * Operation types for the latency breakdown. Each one is further split in
+ * hits (key found / added / removed) and misses.
+ **/
+enum { OP_CONTAINS = 0, OP_ADD, OP_REMOVE, NR_OPS };
+static const char *op_names[NR_OPS] = { "contains", "add", "remove" };
+
 /**
  * Global data.
 **/
 ll_t *ll;
-unsigned int list_size;
+workload_t workload;
+unsigned int nthreads;
 pthread_barrier_t start_barrier;
 int time_to_leave;
-short contains_pct, add_pct, remove_pct;
+int record_latency;
+unsigned long think_iters;
 
 /**
  * The struct that is passed as an argument to each thread.
@@ -32,46 +42,166 @@ typedef struct {
 	int tid;
 	int cpu;
 	unsigned long long ops;
-	char padding[64 - 2*sizeof(int) - sizeof(unsigned long long)];
+	unsigned long long retries;
+	hist_t *hist; /* [NR_OPS][2], hits and misses. */
+	char padding[64 - 2*sizeof(int) - 2*sizeof(unsigned long long) - sizeof(hist_t *)];
 } tdata_t;
 
 void *thread_fn(void *targ);
 
+/**
+ * Think time between operations. The loop body is an empty asm statement so
+ * that the compiler cannot remove it, and its speed is measured once at
+ * startup to turn nanoseconds into iterations.
+ **/
+static inline void think(unsigned long iters)
+{
+	unsigned long i;
+
+	for (i=0; i < iters; i++)
+		__asm__ __volatile__("" ::: "memory");
+}
+
+static unsigned long think_calibrate(unsigned long think_ns)
+{
+	unsigned long long t1, t2;
+	unsigned long iters = 10000000;
+
+	if (!think_ns)
+		return 0;
+
+	t1 = timer_now_ns();
+	think(iters);
+	t2 = timer_now_ns();
+	return (unsigned long)((double)iters * think_ns / (double)(t2 - t1) + 0.5);
+}
+
+static void print_latency_report(tdata_t *threads_data, unsigned int nthreads)
+{
+	hist_t *total;
+	unsigned long long total_retries = 0, total_ops = 0;
+	unsigned int i;
+	int op, miss, h;
+
+	XMALLOC(total, NR_OPS * 2);
+	for (h=0; h < NR_OPS * 2; h++)
+		hist_reset(&total[h]);
+
+	for (i=0; i < nthreads; i++) {
+		for (h=0; h < NR_OPS * 2; h++)
+			hist_merge(&total[h], &threads_data[i].hist[h]);
+		total_retries += threads_data[i].retries;
+		total_ops += threads_data[i].ops;
+	}
+
+	printf("Retries: %llu  Retries/op: %.4lf\n", total_retries,
+	       total_ops ? (double)total_retries / total_ops : 0.0);
+	printf("%-14s %12s %10s %10s %10s %10s\n", "Latency(ns)", "Ops", "p50", "p99",
+	       "p99.9", "max");
+	for (op=0; op < NR_OPS; op++) {
+		for (miss=0; miss < 2; miss++) {
+			hist_t *hist = &total[2*op + miss];
+			if (!hist->count)
+				continue;
+			printf("%-8s %-5s %12llu %10llu %10llu %10llu %10llu\n",
+			       op_names[op], miss ? "miss" : "hit", hist->count,
+			       hist_percentile(hist, 50.0), hist_percentile(hist, 99.0),
+			       hist_percentile(hist, 99.9), hist->max);
+		}
+	}
+
+	XFREE(total);
+}
+
+static void usage(char *prog)
+{
+	print_error_and_exit("usage: %s [-l] [-t think_ns] [-w workload_file] [-d distribution]"
+	                     " [<list_size> <contains_pct> <add_pct> <remove_pct>]\n"
+	                     "  -l           record per-operation latency histograms\n"
+	                     "  -t think_ns  calibrated think time between operations\n"
+	                     "  -w file      read the workload from a spec file (see lib/workload.h)\n"
+	                     "  -d dist      key distribution: uniform, zipf[:theta],\n"
+	                     "               hotspot[:hot_keys[:hot_ops]] or sequential\n"
+	                     "The positional arguments are required without -w and\n"
+	                     "override the spec file otherwise.\n", prog);
+}
+
 int main(int argc, char **argv)
 {
 	timer_tt *wall_timer;
 	pthread_t threads[MAX_THREADS];
 	tdata_t threads_data[MAX_THREADS];
-	unsigned int nthreads = 0, *cpus;
+	unsigned int *cpus;
 	unsigned int i;
+	unsigned long think_ns = 0;
+	char *workload_file = NULL, *dist = NULL;
+	int *prefill_keys;
+	int opt;
 
 	//> Initializations.
-	if (argc != 5)
-		print_error_and_exit("usage: %s <list_size> <contains_pct> <add_pct>"
-		                                            " <remove_pct>\n", argv[0]);
-	list_size = atoi(argv[1]);
-	contains_pct = atoi(argv[2]);
-	add_pct = atoi(argv[3]);
-	remove_pct = atoi(argv[4]);
-	if (contains_pct + add_pct + remove_pct != 100)
-		print_error_and_exit("The total percentage of operations is not 100%%!\n");
+	while ((opt = getopt(argc, argv, "lt:w:d:")) != -1) {
+		switch (opt) {
+		case 'l':
+			record_latency = 1;
+			break;
+		case 't':
+			think_ns = strtoul(optarg, NULL, 10);
+			break;
+		case 'w':
+			workload_file = optarg;
+			break;
+		case 'd':
+			dist = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	workload_init(&workload);
+	if (workload_file)
+		workload_read_file(&workload, workload_file);
+	if (argc - optind == 4) {
+		workload.list_size = atoi(argv[optind]);
+		workload.contains_pct = atoi(argv[optind+1]);
+		workload.add_pct = atoi(argv[optind+2]);
+		workload.remove_pct = atoi(argv[optind+3]);
+	} else if (argc != optind || !workload_file) {
+		usage(argv[0]);
+	}
+	if (dist && workload_parse_dist(&workload, dist))
+		print_error_and_exit("Unknown key distribution '%s'.\n", dist);
+	workload_prepare(&workload);
 
 	get_mtconf_options(&nthreads, &cpus);
+	if (nthreads > MAX_THREADS)
+		print_error_and_exit("At most %d threads are supported.\n", MAX_THREADS);
 	mt_conf_print(nthreads, cpus);
+	mt_conf_print_topology(nthreads, cpus);
+	workload_print(&workload);
+
+	think_iters = think_calibrate(think_ns);
+	if (think_ns)
+		printf("Think time: %lu ns (%lu iterations)\n", think_ns, think_iters);
 
 	if (pthread_barrier_init(&start_barrier, NULL, nthreads+1))
 		print_error_and_exit("Failed to initialize start_barrier.\n");
 	wall_timer = timer_init();
 
 	ll = ll_new();
-	for (i=list_size/2; i > 0; i--)
-		ll_add(ll, i);
+	XMALLOC(prefill_keys, workload.list_size/2);
+	for (i=0; i < workload.list_size/2; i++)
+		prefill_keys[i] = i + 1;
+	ll_add_batch(ll, prefill_keys, workload.list_size/2);
+	XFREE(prefill_keys);
 
 	//> Spawn threads.
 	for (i=0; i < nthreads; i++) {
 		threads_data[i].tid = i;
 		threads_data[i].cpu = cpus[i];
 		threads_data[i].ops = 0;
+		threads_data[i].retries = 0;
+		threads_data[i].hist = NULL;
 		if (pthread_create(&threads[i], NULL, thread_fn, &threads_data[i]))
 			print_error_and_exit("Error creating thread %d.\n", i);
 	}
@@ -80,7 +210,7 @@ int main(int argc, char **argv)
 	pthread_barrier_wait(&start_barrier);
 	timer_start(wall_timer);
 
-	sleep(RUNTIME);
+	sleep(workload.duration);
 	time_to_leave = 1;
 
 	//> Wait for threads to complete their execution.
@@ -100,7 +230,14 @@ int main(int argc, char **argv)
 	double secs = timer_report_sec(wall_timer);
 	double throughout = (double)total_ops / secs / 1000.0;
 	printf("Nthreads: %d  Runtime(sec): %d  ListSize: %d  Workload: %d/%d/%d  Throughput(Kops/sec): %5.2lf\n",
-	        nthreads, RUNTIME, list_size, contains_pct, add_pct, remove_pct, throughout);
+	        nthreads, workload.duration, workload.list_size, workload.contains_pct,
+	        workload.add_pct, workload.remove_pct, throughout);
+
+	if (record_latency) {
+		print_latency_report(threads_data, nthreads);
+		for (i=0; i < nthreads; i++)
+			XFREE(threads_data[i].hist);
+	}
 
 //	ll_print(ll);
 	ll_free(ll);
@@ -113,38 +250,51 @@ int main(int argc, char **argv)
 void *thread_fn(void *targ)
 {
 	tdata_t *mydata = targ;
-	int i;
-	struct drand48_data drand_buffer;
-	long int drand_res;
-
-	//> Initialize the thread-safe (and scalable) random number generator.
-	srand48_r(rand() * mydata->tid, &drand_buffer);
+	op_stream_t stream;
+	unsigned int idx = 0;
+	unsigned long long t1 = 0;
+	int h, ret, type;
 
 	//> Pin thread to the specified cpu.
 	setaffinity_oncpu(mydata->cpu);
 
+	//> Precompute our keys and operations, so that they are not timed.
+	op_stream_init(&stream, &workload, mydata->tid, nthreads);
+
+	//> Allocate the histograms after pinning, so they are local to our node.
+	if (record_latency) {
+		XMALLOC(mydata->hist, NR_OPS * 2);
+		for (h=0; h < NR_OPS * 2; h++)
+			hist_reset(&mydata->hist[h]);
+	}
+
 	//> Wait until master gives the green light!
 	pthread_barrier_wait(&start_barrier);
 
 	while (!time_to_leave) {
-		//> Get a random number.
-		lrand48_r(&drand_buffer, &drand_res);
-		int key = drand_res % (list_size + 1);
-
-		//> Get a random operation.
-		lrand48_r(&drand_buffer, &drand_res);
-		int op = drand_res % 100;
-
-		if (op < contains_pct)
-			ll_contains(ll, key);
-		else if (op < contains_pct + add_pct)
-			ll_add(ll, key);
+		//> Get the next key and operation.
+		int key = stream.keys[idx];
+		type = stream.ops[idx];
+		idx = (idx + 1) & (stream.len - 1);
+
+		if (record_latency)
+			t1 = timer_now_ns();
+
+		if (type == OP_CONTAINS)
+			ret = ll_contains(ll, key);
+		else if (type == OP_ADD)
+			ret = ll_add(ll, key);
 		else
-			ll_remove(ll, key);
+			ret = ll_remove(ll, key);
+
+		if (record_latency)
+			hist_record(&mydata->hist[2*type + !ret], timer_now_ns() - t1);
 
 		mydata->ops++;
-		for (i=0; i < 200; i++);
+		think(think_iters);
 	}
 
+	mydata->retries = ll_retries();
+	op_stream_free(&stream);
 	return NULL;
 }
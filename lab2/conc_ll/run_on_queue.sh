@@ -21,23 +21,17 @@ cd /home/parallel/parlab17/a2/conc_ll
 THREADS=(1 2 4 8 16 32 64 128)
 LIST_SIZES=(1024 8192)
 CONTAINS=("100 0 0" "80 10 10" "20 40 40" "0 50 50")
-TOTAL_CORES=64
+## Thread placement is computed by the benchmark from the machine topology
+## (compact, scatter or socket), see lib/aff.c.
+POLICY=compact
 
 mkdir -p ./results
 
 for thread_num in "${THREADS[@]}"; do
 
-    cores=""
-  for (( i=0; i<thread_num; i++ )); do
-    if [ -z "$cores" ]; then
-      cores=$((i % TOTAL_CORES))
-    else
-      cores="$cores,$((i % TOTAL_CORES))"
-    fi
-  done
-
-  export MT_CONF=$cores
-  echo "$MT_CONF"
+  export MT_POLICY=$POLICY
+  export MT_NTHREADS=$thread_num
+  echo "$MT_POLICY $MT_NTHREADS"
 
         for triplet in "${CONTAINS[@]}"; do
                 for list_size in "${LIST_SIZES[@]}"; do
@@ -48,6 +42,8 @@ for thread_num in "${THREADS[@]}"; do
                         ./x.lazy $list_size $num1 $num2 $num3 1>>./results/lazy.out
                         ./x.nb $list_size $num1 $num2 $num3 1>>./results/nb.out
                         ./x.opt $list_size $num1 $num2 $num3 1>>./results/opt.out
+                        ./x.unrolled $list_size $num1 $num2 $num3 1>>./results/unrolled.out
+                        ./x.rcu $list_size $num1 $num2 $num3 1>>./results/rcu.out
 
                         if [ $thread_num -eq 1 ]; then
                             ./x.serial $list_size $num1 $num2 $num3 1>>./results/serial.out
@@ -0,0 +1,7 @@
+# Update-heavy workload where 80% of the operations hit 10% of the keys.
+mix = 20/40/40
+duration = 10
+list_size = 1024
+distribution = hotspot
+hot_keys = 0.1
+hot_ops = 0.8
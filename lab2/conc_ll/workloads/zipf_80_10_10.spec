@@ -0,0 +1,7 @@
+# Read-mostly workload with skewed (zipfian) keys spread over the list.
+mix = 80/10/10
+duration = 10
+list_size = 8192
+distribution = zipf
+zipf_theta = 0.99
+scramble = 1
@@ -0,0 +1,234 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bounds.h"
+
+static void* xcalloc(size_t nmemb, size_t size) {
+    void* p = calloc(nmemb, size);
+
+    if (!p) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return p;
+}
+
+static inline double dist(int numCoords, const double* a, const double* b) {
+    int    i;
+    double ans = 0.0;
+
+    for (i = 0; i < numCoords; i++)
+        ans += (a[i] - b[i]) * (a[i] - b[i]);
+
+    return sqrt(ans);
+}
+
+bounds_mode_t bounds_mode(void) {
+    char* env = getenv("KMEANS_BOUNDS");
+
+    if (!env || !strcmp(env, "none"))
+        return BOUNDS_NONE;
+    if (!strcmp(env, "hamerly"))
+        return BOUNDS_HAMERLY;
+    if (!strcmp(env, "elkan"))
+        return BOUNDS_ELKAN;
+    fprintf(stderr, "Unknown KMEANS_BOUNDS '%s' (none, hamerly or elkan).\n", env);
+    exit(1);
+}
+
+bounds_t* bounds_init(int numObjs, int numClusters, int numCoords) {
+    bounds_mode_t mode = bounds_mode();
+    bounds_t*     b;
+
+    if (mode == BOUNDS_NONE)
+        return NULL;
+
+    b              = (typeof(b))xcalloc(1, sizeof(*b));
+    b->mode        = mode;
+    b->numObjs     = numObjs;
+    b->numClusters = numClusters;
+    b->numCoords   = numCoords;
+    b->upper       = (typeof(b->upper))xcalloc(numObjs, sizeof(*b->upper));
+    b->drift       = (typeof(b->drift))xcalloc(numClusters, sizeof(*b->drift));
+    b->half_sep    = (typeof(b->half_sep))xcalloc(numClusters, sizeof(*b->half_sep));
+    b->old         = (typeof(b->old))xcalloc((size_t)numClusters * numCoords, sizeof(*b->old));
+    if (mode == BOUNDS_ELKAN) {
+        b->lower = (typeof(b->lower))xcalloc((size_t)numObjs * numClusters, sizeof(*b->lower));
+        b->half_cc =
+          (typeof(b->half_cc))xcalloc((size_t)numClusters * numClusters, sizeof(*b->half_cc));
+    } else {
+        b->lower = (typeof(b->lower))xcalloc(numObjs, sizeof(*b->lower));
+    }
+    return b;
+}
+
+void bounds_free(bounds_t* b) {
+    free(b->upper);
+    free(b->lower);
+    free(b->drift);
+    free(b->half_sep);
+    free(b->half_cc);
+    free(b->old);
+    free(b);
+}
+
+const char* bounds_name(const bounds_t* b) {
+    return b->mode == BOUNDS_ELKAN ? "elkan" : "hamerly";
+}
+
+void bounds_prepare(bounds_t* b, const double* clusters) {
+    int    numClusters = b->numClusters, numCoords = b->numCoords;
+    int    i, j;
+    double d;
+
+    // drift of every centroid, and the two largest (hamerly loosens by the largest other drift)
+    b->max_drift = b->max_drift2 = 0.0;
+    b->max_drift_idx             = -1;
+    for (i = 0; i < numClusters; i++) {
+        d = b->have_old ? dist(numCoords, &clusters[i * numCoords], &b->old[i * numCoords]) : 0.0;
+        b->drift[i] = d;
+        if (d > b->max_drift) {
+            b->max_drift2    = b->max_drift;
+            b->max_drift     = d;
+            b->max_drift_idx = i;
+        } else if (d > b->max_drift2) {
+            b->max_drift2 = d;
+        }
+    }
+    memcpy(b->old, clusters, (size_t)numClusters * numCoords * sizeof(*b->old));
+    b->have_old = 1;
+
+    for (i = 0; i < numClusters; i++)
+        b->half_sep[i] = DBL_MAX;
+    for (i = 0; i < numClusters; i++) {
+        for (j = i + 1; j < numClusters; j++) {
+            d = 0.5 * dist(numCoords, &clusters[i * numCoords], &clusters[j * numCoords]);
+            if (b->half_cc) {
+                b->half_cc[i * numClusters + j] = d;
+                b->half_cc[j * numClusters + i] = d;
+            }
+            if (d < b->half_sep[i])
+                b->half_sep[i] = d;
+            if (d < b->half_sep[j])
+                b->half_sep[j] = d;
+        }
+    }
+}
+
+// Full search, which also (re)initialises the bounds of object i.
+static int assign_full(bounds_t* b, const double* object, int i, const double* clusters) {
+    int     numClusters = b->numClusters, numCoords = b->numCoords;
+    int     j, index = 0;
+    double  d, min1 = DBL_MAX, min2 = DBL_MAX;
+    double* lower = (b->mode == BOUNDS_ELKAN) ? &b->lower[(long)i * numClusters] : NULL;
+
+    for (j = 0; j < numClusters; j++) {
+        d = dist(numCoords, object, &clusters[j * numCoords]);
+        if (lower)
+            lower[j] = d;
+        if (d < min1) {
+            min2  = min1;
+            min1  = d;
+            index = j;
+        } else if (d < min2) {
+            min2 = d;
+        }
+    }
+    b->upper[i] = min1;
+    if (!lower)
+        b->lower[i] = min2;
+    return index;
+}
+
+static int assign_hamerly(bounds_t*     b,
+                          const double* object,
+                          int           i,
+                          int           a,
+                          const double* clusters,
+                          long long*    ndist) {
+    double m;
+
+    b->upper[i] += b->drift[a];
+    b->lower[i] -= (a == b->max_drift_idx) ? b->max_drift2 : b->max_drift;
+
+    m = b->lower[i] > b->half_sep[a] ? b->lower[i] : b->half_sep[a];
+    if (b->upper[i] <= m)
+        return a;
+
+    // tighten the upper bound and try again before giving up
+    b->upper[i] = dist(b->numCoords, object, &clusters[a * b->numCoords]);
+    (*ndist)++;
+    if (b->upper[i] <= m)
+        return a;
+
+    *ndist += b->numClusters;
+    return assign_full(b, object, i, clusters);
+}
+
+static int assign_elkan(bounds_t*     b,
+                        const double* object,
+                        int           i,
+                        int           a,
+                        const double* clusters,
+                        long long*    ndist) {
+    int     numClusters = b->numClusters, numCoords = b->numCoords;
+    int     j, stale = 1;
+    double* lower = &b->lower[(long)i * numClusters];
+    double* u     = &b->upper[i];
+    double  d;
+
+    *u += b->drift[a];
+    for (j = 0; j < numClusters; j++)
+        lower[j] = (lower[j] > b->drift[j]) ? lower[j] - b->drift[j] : 0.0;
+
+    if (*u <= b->half_sep[a])
+        return a;
+
+    for (j = 0; j < numClusters; j++) {
+        if (j == a || *u <= lower[j] || *u <= b->half_cc[a * numClusters + j])
+            continue;
+        if (stale) {
+            *u       = dist(numCoords, object, &clusters[a * numCoords]);
+            lower[a] = *u;
+            stale    = 0;
+            (*ndist)++;
+            if (*u <= lower[j] || *u <= b->half_cc[a * numClusters + j])
+                continue;
+        }
+        d        = dist(numCoords, object, &clusters[j * numCoords]);
+        lower[j] = d;
+        (*ndist)++;
+        if (d < *u || (d == *u && j < a)) {
+            a  = j;
+            *u = d;
+        }
+    }
+    return a;
+}
+
+int bounds_assign(bounds_t*     b,
+                  const double* object,
+                  int           i,
+                  int           current,
+                  const double* clusters,
+                  long long*    ndist) {
+    if (current < 0) {
+        *ndist += b->numClusters;
+        return assign_full(b, object, i, clusters);
+    }
+    if (b->mode == BOUNDS_ELKAN)
+        return assign_elkan(b, object, i, current, clusters, ndist);
+    return assign_hamerly(b, object, i, current, clusters, ndist);
+}
+
+void bounds_account(bounds_t* b, long long ndist) {
+    b->computed += ndist;
+    b->possible += (long long)b->numObjs * b->numClusters;
+}
+
+double bounds_skipped(const bounds_t* b) {
+    return b->possible ? 1.0 - (double)b->computed / b->possible : 0.0;
+}
@@ -0,0 +1,77 @@
+#ifndef _H_BOUNDS
+#define _H_BOUNDS
+
+/*
+ * Triangle-inequality pruning of the assignment step.
+ *
+ * Every point keeps an upper bound on the distance to its own centroid and lower bounds on the
+ * distance to the others. After the centroids move by drift[j], the bounds are loosened by the
+ * drift instead of being recomputed, and a point whose upper bound stays below its lower bound
+ * (or below half the distance from its centroid to the closest other one) cannot change
+ * membership, so its distances are skipped.
+ *
+ *  - hamerly: a single lower bound per point (to the second-closest centroid). O(numObjs) memory.
+ *  - elkan:   one lower bound per point and centroid, plus all inter-centroid distances. Prunes
+ *             more, but needs O(numObjs * numClusters) memory.
+ *
+ * The result is exact: a point changes membership exactly as with the full search (up to ties
+ * between equally distant centroids). Bounds are kept on distances, not squared distances.
+ *
+ * The mode is picked with KMEANS_BOUNDS=none|hamerly|elkan (default none). Only the double, aos
+ * path of the reduction k-means has bounds: it refuses KMEANS_BOUNDS together with
+ * KMEANS_PRECISION=float|float-kahan or KMEANS_LAYOUT=soa.
+ */
+
+typedef enum { BOUNDS_NONE = 0, BOUNDS_HAMERLY, BOUNDS_ELKAN } bounds_mode_t;
+
+typedef struct {
+    bounds_mode_t mode;
+    int           numObjs;
+    int           numClusters;
+    int           numCoords;
+    double*       upper;    // [numObjs]
+    double*       lower;    // [numObjs] (hamerly) or [numObjs][numClusters] (elkan)
+    double*       drift;    // [numClusters]: how far each centroid moved in the last update
+    double*       half_sep; // [numClusters]: half the distance to the closest other centroid
+    double*       half_cc;  // [numClusters][numClusters]: half the inter-centroid distances (elkan)
+    double*       old;      // [numClusters][numCoords]: centroids of the previous iteration
+    double        max_drift, max_drift2; // largest and second largest drift
+    int           max_drift_idx;
+    int           have_old;
+    long long     computed; // distance computations done so far
+    long long     possible; // and those of a full search
+} bounds_t;
+
+// The mode KMEANS_BOUNDS asks for.
+bounds_mode_t bounds_mode(void);
+
+// NULL if KMEANS_BOUNDS is unset or "none".
+bounds_t*   bounds_init(int numObjs, int numClusters, int numCoords);
+void        bounds_free(bounds_t* b);
+const char* bounds_name(const bounds_t* b);
+
+/*
+ * Call once per iteration, before the assignment step, with the current centroids: computes their
+ * drift since the last call and the inter-centroid distances.
+ */
+void bounds_prepare(bounds_t* b, const double* clusters); /* [numClusters][numCoords] */
+
+/*
+ * Nearest centroid of object i, whose current membership is `current` (-1 if none yet). Only
+ * touches the bounds of object i, so different objects can be assigned in parallel. The number of
+ * distances computed is added to *ndist.
+ */
+int bounds_assign(bounds_t*     b,
+                  const double* object, /* [numCoords] */
+                  int           i,
+                  int           current,
+                  const double* clusters, /* [numClusters][numCoords] */
+                  long long*    ndist);
+
+// Account for one assignment step that computed ndist distances.
+void bounds_account(bounds_t* b, long long ndist);
+
+// Fraction of the distance computations of a full search that were skipped so far.
+double bounds_skipped(const bounds_t* b);
+
+#endif
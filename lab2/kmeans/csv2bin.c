@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h> /* getopt() */
+
+#include "dataset.h"
+
+/*
+ * Convert a CSV file (one object per line; fields separated by commas, semicolons or white space)
+ * to the binary format of dataset.h. Lines that are empty or start with '#' are skipped, and so is
+ * a first line that does not start with a number (a header). aos output is written as it is read;
+ * soa output needs the whole dataset in memory to transpose it.
+ */
+
+static void usage(char* argv0) {
+    char* help = "Usage: %s [switches] input.csv output.bin\n"
+                 "       -t dtype           : float64|float32 (default : float64)\n"
+                 "       -l layout          : aos|soa (default : aos)\n"
+                 "       -h                 : print this help information\n"
+                 "       input.csv may be - for the standard input\n";
+    fprintf(stderr, help, argv0);
+    exit(-1);
+}
+
+static void* xrealloc(void* p, size_t size) {
+    if (!(p = realloc(p, size))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return p;
+}
+
+// Parse the fields of line into (*row)[]; returns their number.
+static long parse(char* line, double** row, long* cap, long lineno) {
+    char* field;
+    char* end;
+    long  n = 0;
+
+    for (field = strtok(line, ",; \t\r\n"); field; field = strtok(NULL, ",; \t\r\n")) {
+        if (n == *cap) {
+            *cap = *cap ? 2 * *cap : 16;
+            *row = (double*)xrealloc(*row, *cap * sizeof(**row));
+        }
+        (*row)[n++] = strtod(field, &end);
+        if (*end) {
+            fprintf(stderr, "line %ld: '%s' is not a number\n", lineno, field);
+            exit(1);
+        }
+    }
+    return n;
+}
+
+static void write_values(FILE* out, const double* v, long n, int dtype) {
+    long i;
+
+    if (dtype == DATASET_FLOAT64) {
+        if (fwrite(v, sizeof(*v), n, out) != (size_t)n) {
+            perror("fwrite");
+            exit(1);
+        }
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        float f = v[i];
+
+        if (fwrite(&f, sizeof(f), 1, out) != 1) {
+            perror("fwrite");
+            exit(1);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    dataset_header_t hdr;
+    FILE *           in, *out;
+    char*            line = NULL;
+    size_t           linecap = 0;
+    double*          row = NULL;  // [numCoords] current object
+    double*          all = NULL;  // [numObjs][numCoords] for soa
+    long             rowcap = 0, allcap = 0, lineno = 0, n, i, j;
+    int              opt;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DATASET_MAGIC, sizeof(hdr.magic));
+    hdr.version     = DATASET_VERSION;
+    hdr.dtype       = DATASET_FLOAT64;
+    hdr.layout      = DATASET_AOS;
+    hdr.data_offset = DATASET_ALIGN;
+
+    while ((opt = getopt(argc, argv, "t:l:h")) != EOF) {
+        switch (opt) {
+            case 't':
+                if (!strcmp(optarg, "float64"))
+                    hdr.dtype = DATASET_FLOAT64;
+                else if (!strcmp(optarg, "float32"))
+                    hdr.dtype = DATASET_FLOAT32;
+                else
+                    usage(argv[0]);
+                break;
+            case 'l':
+                if (!strcmp(optarg, "aos"))
+                    hdr.layout = DATASET_AOS;
+                else if (!strcmp(optarg, "soa"))
+                    hdr.layout = DATASET_SOA;
+                else
+                    usage(argv[0]);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+    if (argc - optind != 2)
+        usage(argv[0]);
+
+    in = strcmp(argv[optind], "-") ? fopen(argv[optind], "r") : stdin;
+    if (!in || !(out = fopen(argv[optind + 1], "wb"))) {
+        perror(in ? argv[optind + 1] : argv[optind]);
+        exit(1);
+    }
+    if (fseek(out, hdr.data_offset, SEEK_SET)) {
+        perror("fseek");
+        exit(1);
+    }
+
+    while (getline(&line, &linecap, in) > 0) {
+        lineno++;
+        n = strspn(line, " \t");
+        if (line[n] == '#' || line[n] == '\n' || line[n] == '\r' || line[n] == '\0')
+            continue;
+        if (lineno == 1 && !strchr("+-.0123456789", line[n]))
+            continue;
+
+        n = parse(line, &row, &rowcap, lineno);
+        if (!n)
+            continue;
+        if (!hdr.numCoords)
+            hdr.numCoords = n;
+        if (n != (long)hdr.numCoords) {
+            fprintf(stderr, "line %ld: %ld fields, expected %ld\n", lineno, n, (long)hdr.numCoords);
+            exit(1);
+        }
+
+        if (hdr.layout == DATASET_AOS) {
+            write_values(out, row, n, hdr.dtype);
+        } else {
+            if ((long)(hdr.numObjs + 1) * n > allcap) {
+                allcap = allcap ? 2 * allcap : 1024 * n;
+                all    = (double*)xrealloc(all, allcap * sizeof(*all));
+            }
+            memcpy(&all[hdr.numObjs * n], row, n * sizeof(*row));
+        }
+        hdr.numObjs++;
+    }
+
+    if (!hdr.numObjs) {
+        fprintf(stderr, "%s: no objects\n", argv[optind]);
+        exit(1);
+    }
+    if (hdr.layout == DATASET_SOA) {
+        for (j = 0; j < (long)hdr.numCoords; j++)
+            for (i = 0; i < (long)hdr.numObjs; i++)
+                write_values(out, &all[i * hdr.numCoords + j], 1, hdr.dtype);
+    }
+
+    // the header goes last, once numObjs is known
+    if (fseek(out, 0, SEEK_SET) || fwrite(&hdr, sizeof(hdr), 1, out) != 1 || fclose(out)) {
+        perror(argv[optind + 1]);
+        exit(1);
+    }
+    if (in != stdin)
+        fclose(in);
+    fprintf(stderr,
+            "%s: %ld objects, %ld coordinates, %s, %s\n",
+            argv[optind + 1],
+            (long)hdr.numObjs,
+            (long)hdr.numCoords,
+            hdr.dtype == DATASET_FLOAT64 ? "float64" : "float32",
+            hdr.layout == DATASET_AOS ? "aos" : "soa");
+
+    free(line);
+    free(row);
+    free(all);
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataset.h"
+#include "kmeans.h"
+#include "placement.h"
+
+static void fail(const char* path, const char* what) {
+    fprintf(stderr, "%s: %s\n", path, what);
+    exit(1);
+}
+
+void dataset_read_header(const char* path, dataset_header_t* hdr) {
+    struct stat st;
+    size_t      elsize;
+    int         fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st)) {
+        perror(path);
+        exit(1);
+    }
+    if (pread(fd, hdr, sizeof(*hdr), 0) != sizeof(*hdr) ||
+        memcmp(hdr->magic, DATASET_MAGIC, sizeof(hdr->magic)))
+        fail(path, "not a k-means dataset");
+    if (hdr->version != DATASET_VERSION)
+        fail(path, "unsupported dataset version");
+    if (hdr->dtype != DATASET_FLOAT64 && hdr->dtype != DATASET_FLOAT32)
+        fail(path, "unknown dtype");
+    if (hdr->layout != DATASET_AOS && hdr->layout != DATASET_SOA)
+        fail(path, "unknown layout");
+    if (hdr->numCoords < 1 || hdr->data_offset < sizeof(*hdr))
+        fail(path, "corrupt header");
+
+    elsize = (hdr->dtype == DATASET_FLOAT64) ? sizeof(double) : sizeof(float);
+    if ((uint64_t)st.st_size < hdr->data_offset + hdr->numObjs * hdr->numCoords * elsize)
+        fail(path, "truncated dataset");
+    close(fd);
+}
+
+/*
+ * Touch one byte of every page of objects[numObjs][numCoords], distributing the blocks of objects
+ * like the compute loops do.
+ */
+static void prefault(const double* objects, long numObjs, long numCoords) {
+    long page = sysconf(_SC_PAGESIZE);
+    long b;
+    char sum = 0;
+
+    // clang-format off
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(+ : sum)
+#endif
+    // clang-format on
+    for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+        const volatile char* p   = (const volatile char*)&objects[b * numCoords];
+        const volatile char* end = (const volatile char*)&objects[(b + OBJ_BLOCK < numObjs ? b + OBJ_BLOCK : numObjs) * numCoords];
+
+        for (p = (const volatile char*)((unsigned long)p & ~(page - 1)); p < end; p += page)
+            sum += *p;
+    }
+    (void)sum;
+}
+
+static int prefault_requested(void) {
+    char* env = getenv("KMEANS_PREFAULT");
+
+    return env && strcmp(env, "0");
+}
+
+/*
+ * Fill in ds for count objects of the file starting at object first, and map them: the requested
+ * objects only (aos), or every column (soa), from a page boundary. Returns the first coordinate of
+ * object first (aos) or of the file (soa), or NULL if there is nothing to map.
+ */
+static char*
+map_objects(const char* path, const dataset_header_t* hdr, long first, long count, dataset_t* ds) {
+    long   page = sysconf(_SC_PAGESIZE);
+    size_t elsize, start, len;
+    char*  map;
+    int    fd;
+
+    if (count < 0)
+        count = hdr->numObjs - first;
+    if (first < 0 || first + count > (long)hdr->numObjs)
+        fail(path, "object range out of bounds");
+
+    ds->numObjs   = count;
+    ds->numCoords = hdr->numCoords;
+    ds->dtype     = hdr->dtype;
+    ds->layout    = hdr->layout;
+    elsize        = (hdr->dtype == DATASET_FLOAT64) ? sizeof(double) : sizeof(float);
+
+    if (hdr->layout == DATASET_AOS) {
+        start = hdr->data_offset + (size_t)first * hdr->numCoords * elsize;
+        len   = (size_t)count * hdr->numCoords * elsize;
+    } else {
+        start = hdr->data_offset;
+        len   = (size_t)hdr->numObjs * hdr->numCoords * elsize;
+    }
+    ds->map_len = len + start % page;
+    if (ds->map_len == 0)
+        return NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        perror(path);
+        exit(1);
+    }
+    posix_fadvise(fd, start - start % page, ds->map_len, POSIX_FADV_SEQUENTIAL);
+    // private and writable: the objects arrays of the drivers are not const, writes stay in memory
+    map = (char*)mmap(NULL, ds->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, start - start % page);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    close(fd);
+    madvise(map, ds->map_len, MADV_SEQUENTIAL);
+    ds->map = map;
+    return map + start % page;
+}
+
+static dataset_t* dataset_alloc(void) {
+    dataset_t* ds = (dataset_t*)calloc(1, sizeof(*ds));
+
+    if (!ds) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return ds;
+}
+
+dataset_t* dataset_open(const char* path, long first, long count) {
+    dataset_header_t hdr;
+    dataset_t*       ds = dataset_alloc();
+    char*            map;
+    long             b;
+
+    dataset_read_header(path, &hdr);
+    if (!(map = map_objects(path, &hdr, first, count, ds))) {
+        ds->objects = (double*)malloc(1);
+        ds->owned   = 1;
+        return ds;
+    }
+    count = ds->numObjs;
+    // the whole range is about to be used: read it ahead
+    madvise(ds->map, ds->map_len, MADV_WILLNEED);
+
+    if (hdr.dtype == DATASET_FLOAT64 && hdr.layout == DATASET_AOS) {
+        // zero copy: the file is the objects array
+        ds->objects = (double*)map;
+        if (prefault_requested())
+            prefault(ds->objects, count, hdr.numCoords);
+        return ds;
+    }
+
+    // convert into a buffer written with the schedule of the compute loops (first touch)
+    ds->objects = (double*)placement_alloc((size_t)count * hdr.numCoords * sizeof(double));
+    ds->owned   = 1;
+    // clang-format off
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    // clang-format on
+    for (b = 0; b < count; b += OBJ_BLOCK) {
+        long i, j, n = hdr.numCoords;
+
+        for (i = b; i < b + OBJ_BLOCK && i < count; i++)
+            for (j = 0; j < n; j++) {
+                if (hdr.dtype == DATASET_FLOAT64)
+                    ds->objects[i * n + j] = ((double*)map)[(size_t)j * hdr.numObjs + first + i];
+                else if (hdr.layout == DATASET_AOS)
+                    ds->objects[i * n + j] = ((float*)map)[i * n + j];
+                else
+                    ds->objects[i * n + j] = ((float*)map)[(size_t)j * hdr.numObjs + first + i];
+            }
+    }
+    munmap(ds->map, ds->map_len);
+    ds->map = NULL;
+    return ds;
+}
+
+dataset_t* dataset_map(const char* path) {
+    dataset_header_t hdr;
+    dataset_t*       ds = dataset_alloc();
+
+    dataset_read_header(path, &hdr);
+    ds->data     = map_objects(path, &hdr, 0, -1, ds);
+    ds->fileObjs = hdr.numObjs;
+    // the stream samples the file with a stride (see stream.h): no readahead
+    if (ds->map)
+        madvise(ds->map, ds->map_len, MADV_RANDOM);
+    return ds;
+}
+
+void dataset_get(const dataset_t* ds, long i, double* object) {
+    long j, n = ds->numCoords;
+
+    if (ds->dtype == DATASET_FLOAT64 && ds->layout == DATASET_AOS)
+        memcpy(object, &((const double*)ds->data)[i * n], n * sizeof(*object));
+    else if (ds->dtype == DATASET_FLOAT64)
+        for (j = 0; j < n; j++)
+            object[j] = ((const double*)ds->data)[j * ds->fileObjs + i];
+    else if (ds->layout == DATASET_AOS)
+        for (j = 0; j < n; j++)
+            object[j] = ((const float*)ds->data)[i * n + j];
+    else
+        for (j = 0; j < n; j++)
+            object[j] = ((const float*)ds->data)[j * ds->fileObjs + i];
+}
+
+void dataset_close(dataset_t* ds) {
+    if (ds->owned)
+        free(ds->objects);
+    if (ds->map)
+        munmap(ds->map, ds->map_len);
+    free(ds);
+}
@@ -0,0 +1,78 @@
+#ifndef _H_DATASET
+#define _H_DATASET
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary dataset files, an alternative to the synthetic data of dataset_generation().
+ *
+ * A 64-byte header (host byte order) followed, at data_offset, by the coordinates:
+ *
+ *     layout aos: [numObjs][numCoords]     layout soa: [numCoords][numObjs]
+ *
+ * of dtype float64 or float32. csv2bin puts the data at offset DATASET_ALIGN, so that they start on
+ * a page. float64/aos is the layout of the objects array itself: such files are mapped and used in
+ * place, without a copy. Other files are converted into a private buffer.
+ *
+ * dataset_open() advises the mapping MADV_SEQUENTIAL/MADV_WILLNEED for kernel readahead. KMEANS_PREFAULT=1
+ * additionally faults every page in before the computation, in parallel and with the static
+ * schedule of the compute loops (see OBJ_BLOCK), so that with a cold page cache the reads are
+ * issued by many threads at once and each page lands on the node of the thread that will use it.
+ *
+ * dataset_map() is for streaming a file that may not fit in memory (see stream.h): the file is
+ * mapped as it is, advised MADV_RANDOM, and dataset_get() converts one object at a time.
+ *
+ * csv2bin converts CSV files to this format.
+ */
+
+#define DATASET_MAGIC   "KMEANSDS"
+#define DATASET_VERSION 1
+#define DATASET_ALIGN   4096
+
+enum { DATASET_FLOAT64 = 1, DATASET_FLOAT32 = 2 };
+enum { DATASET_AOS = 0, DATASET_SOA = 1 };
+
+typedef struct dataset_header {
+    char     magic[8];    /* DATASET_MAGIC, not NUL-terminated */
+    uint32_t version;     /* DATASET_VERSION */
+    uint32_t dtype;       /* DATASET_FLOAT64 | DATASET_FLOAT32 */
+    uint32_t layout;      /* DATASET_AOS | DATASET_SOA */
+    uint32_t reserved;
+    uint64_t numObjs;
+    uint64_t numCoords;
+    uint64_t data_offset; /* bytes from the start of the file */
+    uint64_t pad[2];
+} dataset_header_t;
+
+typedef struct dataset {
+    long    numObjs; /* objects in this dataset_t, i.e. in the range that was opened */
+    long    numCoords;
+    double* objects; /* [numObjs][numCoords] */
+    void*   map;     /* mapping of the file, or NULL */
+    size_t  map_len;
+    int     owned; /* objects is a converted copy, to be freed */
+
+    /* dataset_map() only */
+    const void* data;     /* the coordinates, in the dtype and layout of the file */
+    long        fileObjs; /* objects in the file: the row length of soa */
+    int         dtype;
+    int         layout;
+} dataset_t;
+
+/*
+ * Open count objects of the file at path, starting at object first (count < 0: up to the end).
+ * Errors are fatal.
+ */
+dataset_t* dataset_open(const char* path, long first, long count);
+// Map the whole file as it is, for dataset_get(); objects is NULL.
+dataset_t* dataset_map(const char* path);
+void       dataset_close(dataset_t* ds);
+
+// Object i of a dataset_map()ed file, converted to double.
+void dataset_get(const dataset_t* ds, long i, double* object);
+
+// Read and check the header only.
+void dataset_read_header(const char* path, dataset_header_t* hdr);
+
+#endif
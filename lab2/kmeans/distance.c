@@ -0,0 +1,329 @@
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define DIST_X86
+#endif
+
+#include "distance.h"
+
+// Tile sizes: MR points by NR centroids. NR is a multiple of the vector width.
+#define GENERIC_MR 4
+#define GENERIC_NR 8
+#define AVX2_MR    4
+#define AVX2_NR    8  /* 2 x 4 doubles */
+#define AVX512_MR  8
+#define AVX512_NR  16 /* 2 x 8 doubles */
+#define MAX_MR     8
+
+/*
+ * Fold the per-lane minima of a tile row into a single one. Within a lane the minimum already
+ * belongs to the lowest index among equal distances, so ties between lanes go to the lower index
+ * as well, exactly like the scalar loop.
+ */
+static inline void reduce_lanes(const double* v, const double* idx, int lanes, double* bestv,
+                                int* besti) {
+    int    j, bi = (int)idx[0];
+    double bv = v[0];
+
+    for (j = 1; j < lanes; j++) {
+        if (v[j] < bv || (v[j] == bv && (int)idx[j] < bi)) {
+            bv = v[j];
+            bi = (int)idx[j];
+        }
+    }
+    *bestv = bv;
+    *besti = bi;
+}
+
+static void kernel_generic(const dist_centroids_t* c, const double* x, double* bestv, int* besti) {
+    int           numCoords = c->numCoords;
+    int           panel, k, p, j;
+    double        acc[GENERIC_MR][GENERIC_NR];
+    const double* pc;
+    const double* norms;
+    double        v;
+
+    for (p = 0; p < GENERIC_MR; p++) {
+        bestv[p] = DBL_MAX;
+        besti[p] = 0;
+    }
+
+    for (panel = 0; panel < c->npanels; panel++) {
+        pc    = c->panels + (long)panel * numCoords * GENERIC_NR;
+        norms = c->norms + panel * GENERIC_NR;
+
+        memset(acc, 0, sizeof(acc));
+        for (k = 0; k < numCoords; k++)
+            for (p = 0; p < GENERIC_MR; p++)
+                for (j = 0; j < GENERIC_NR; j++)
+                    acc[p][j] += x[p * numCoords + k] * pc[k * GENERIC_NR + j];
+
+        for (p = 0; p < GENERIC_MR; p++) {
+            for (j = 0; j < GENERIC_NR; j++) {
+                v = norms[j] - 2.0 * acc[p][j];
+                if (v < bestv[p]) {
+                    bestv[p] = v;
+                    besti[p] = panel * GENERIC_NR + j;
+                }
+            }
+        }
+    }
+}
+
+#ifdef DIST_X86
+__attribute__((target("avx2,fma"))) static void
+kernel_avx2(const dist_centroids_t* c, const double* x, double* bestv, int* besti) {
+    int           numCoords = c->numCoords;
+    int           panel, k, p;
+    __m256d       acc[AVX2_MR][2], bv[AVX2_MR], bi[AVX2_MR];
+    __m256d       c0, c1, xk, v, lt, n0, n1;
+    __m256d       idx0  = _mm256_set_pd(3, 2, 1, 0);
+    __m256d       idx1  = _mm256_set_pd(7, 6, 5, 4);
+    __m256d       step  = _mm256_set1_pd(AVX2_NR);
+    __m256d       minus2 = _mm256_set1_pd(-2.0);
+    const double* pc;
+    double        lv[4], li[4];
+
+    for (p = 0; p < AVX2_MR; p++) {
+        bv[p] = _mm256_set1_pd(DBL_MAX);
+        bi[p] = _mm256_setzero_pd();
+    }
+
+    for (panel = 0; panel < c->npanels; panel++) {
+        pc = c->panels + (long)panel * numCoords * AVX2_NR;
+
+        for (p = 0; p < AVX2_MR; p++)
+            acc[p][0] = acc[p][1] = _mm256_setzero_pd();
+
+        for (k = 0; k < numCoords; k++) {
+            c0 = _mm256_load_pd(pc + k * AVX2_NR);
+            c1 = _mm256_load_pd(pc + k * AVX2_NR + 4);
+            for (p = 0; p < AVX2_MR; p++) {
+                xk        = _mm256_broadcast_sd(x + p * numCoords + k);
+                acc[p][0] = _mm256_fmadd_pd(xk, c0, acc[p][0]);
+                acc[p][1] = _mm256_fmadd_pd(xk, c1, acc[p][1]);
+            }
+        }
+
+        // fused argmin: ||c||^2 - 2 x.c against the running minimum of every lane
+        n0 = _mm256_load_pd(c->norms + panel * AVX2_NR);
+        n1 = _mm256_load_pd(c->norms + panel * AVX2_NR + 4);
+        for (p = 0; p < AVX2_MR; p++) {
+            v     = _mm256_fmadd_pd(minus2, acc[p][0], n0);
+            lt    = _mm256_cmp_pd(v, bv[p], _CMP_LT_OQ);
+            bv[p] = _mm256_blendv_pd(bv[p], v, lt);
+            bi[p] = _mm256_blendv_pd(bi[p], idx0, lt);
+            v     = _mm256_fmadd_pd(minus2, acc[p][1], n1);
+            lt    = _mm256_cmp_pd(v, bv[p], _CMP_LT_OQ);
+            bv[p] = _mm256_blendv_pd(bv[p], v, lt);
+            bi[p] = _mm256_blendv_pd(bi[p], idx1, lt);
+        }
+        idx0 = _mm256_add_pd(idx0, step);
+        idx1 = _mm256_add_pd(idx1, step);
+    }
+
+    for (p = 0; p < AVX2_MR; p++) {
+        _mm256_storeu_pd(lv, bv[p]);
+        _mm256_storeu_pd(li, bi[p]);
+        reduce_lanes(lv, li, 4, &bestv[p], &besti[p]);
+    }
+}
+
+__attribute__((target("avx512f"))) static void
+kernel_avx512(const dist_centroids_t* c, const double* x, double* bestv, int* besti) {
+    int           numCoords = c->numCoords;
+    int           panel, k, p;
+    __m512d       acc[AVX512_MR][2], bv[AVX512_MR], bi[AVX512_MR];
+    __m512d       c0, c1, xk, v, n0, n1;
+    __mmask8      lt;
+    __m512d       idx0   = _mm512_set_pd(7, 6, 5, 4, 3, 2, 1, 0);
+    __m512d       idx1   = _mm512_set_pd(15, 14, 13, 12, 11, 10, 9, 8);
+    __m512d       step   = _mm512_set1_pd(AVX512_NR);
+    __m512d       minus2 = _mm512_set1_pd(-2.0);
+    const double* pc;
+    double        lv[8], li[8];
+
+    for (p = 0; p < AVX512_MR; p++) {
+        bv[p] = _mm512_set1_pd(DBL_MAX);
+        bi[p] = _mm512_setzero_pd();
+    }
+
+    for (panel = 0; panel < c->npanels; panel++) {
+        pc = c->panels + (long)panel * numCoords * AVX512_NR;
+
+        for (p = 0; p < AVX512_MR; p++)
+            acc[p][0] = acc[p][1] = _mm512_setzero_pd();
+
+        for (k = 0; k < numCoords; k++) {
+            c0 = _mm512_load_pd(pc + k * AVX512_NR);
+            c1 = _mm512_load_pd(pc + k * AVX512_NR + 8);
+            for (p = 0; p < AVX512_MR; p++) {
+                xk        = _mm512_set1_pd(x[p * numCoords + k]);
+                acc[p][0] = _mm512_fmadd_pd(xk, c0, acc[p][0]);
+                acc[p][1] = _mm512_fmadd_pd(xk, c1, acc[p][1]);
+            }
+        }
+
+        n0 = _mm512_load_pd(c->norms + panel * AVX512_NR);
+        n1 = _mm512_load_pd(c->norms + panel * AVX512_NR + 8);
+        for (p = 0; p < AVX512_MR; p++) {
+            v     = _mm512_fmadd_pd(minus2, acc[p][0], n0);
+            lt    = _mm512_cmp_pd_mask(v, bv[p], _CMP_LT_OQ);
+            bv[p] = _mm512_mask_blend_pd(lt, bv[p], v);
+            bi[p] = _mm512_mask_blend_pd(lt, bi[p], idx0);
+            v     = _mm512_fmadd_pd(minus2, acc[p][1], n1);
+            lt    = _mm512_cmp_pd_mask(v, bv[p], _CMP_LT_OQ);
+            bv[p] = _mm512_mask_blend_pd(lt, bv[p], v);
+            bi[p] = _mm512_mask_blend_pd(lt, bi[p], idx1);
+        }
+        idx0 = _mm512_add_pd(idx0, step);
+        idx1 = _mm512_add_pd(idx1, step);
+    }
+
+    for (p = 0; p < AVX512_MR; p++) {
+        _mm512_storeu_pd(lv, bv[p]);
+        _mm512_storeu_pd(li, bi[p]);
+        reduce_lanes(lv, li, 8, &bestv[p], &besti[p]);
+    }
+}
+#endif /* DIST_X86 */
+
+int dist_use_scalar(void) {
+    char* env = getenv("KMEANS_DIST");
+
+    return env && !strcmp(env, "scalar");
+}
+
+static void select_kernel(dist_centroids_t* c) {
+    char* env  = getenv("KMEANS_DIST");
+    char* want = (env && strcmp(env, "scalar")) ? env : NULL;
+
+    if (want && strcmp(want, "generic") && strcmp(want, "avx2") && strcmp(want, "avx512")) {
+        fprintf(stderr, "Unknown KMEANS_DIST '%s' (scalar, generic, avx2 or avx512).\n", want);
+        exit(1);
+    }
+
+    int has_avx512 = 0, has_avx2 = 0;
+
+#ifdef DIST_X86
+    __builtin_cpu_init();
+    has_avx512 = __builtin_cpu_supports("avx512f");
+    has_avx2   = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    // an explicit request is not quietly replaced by another kernel
+    if ((want && !strcmp(want, "avx512") && !has_avx512) ||
+        (want && !strcmp(want, "avx2") && !has_avx2)) {
+        fprintf(stderr, "KMEANS_DIST=%s is not supported by this CPU.\n", want);
+        exit(1);
+    }
+
+    c->kernel = kernel_generic;
+    c->mr     = GENERIC_MR;
+    c->nr     = GENERIC_NR;
+    c->name   = "generic";
+
+#ifdef DIST_X86
+    if ((!want || !strcmp(want, "avx512")) && has_avx512) {
+        c->kernel = kernel_avx512;
+        c->mr     = AVX512_MR;
+        c->nr     = AVX512_NR;
+        c->name   = "avx512";
+    } else if ((!want || !strcmp(want, "avx2")) && has_avx2) {
+        c->kernel = kernel_avx2;
+        c->mr     = AVX2_MR;
+        c->nr     = AVX2_NR;
+        c->name   = "avx2";
+    }
+#endif
+}
+
+dist_centroids_t* dist_init(int numClusters, int numCoords) {
+    dist_centroids_t* c;
+
+    c = (typeof(c))calloc(1, sizeof(*c));
+    if (!c) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    c->numClusters = numClusters;
+    c->numCoords   = numCoords;
+    select_kernel(c);
+    c->npanels = (numClusters + c->nr - 1) / c->nr;
+
+    if (posix_memalign((void**)&c->panels, 64,
+                       (size_t)c->npanels * numCoords * c->nr * sizeof(*c->panels)) ||
+        posix_memalign((void**)&c->norms, 64, (size_t)c->npanels * c->nr * sizeof(*c->norms))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return c;
+}
+
+void dist_free(dist_centroids_t* c) {
+    free(c->panels);
+    free(c->norms);
+    free(c);
+}
+
+void dist_pack(dist_centroids_t* c, const double* clusters) {
+    int     numCoords = c->numCoords, nr = c->nr;
+    int     i, k;
+    double* pc;
+    double  norm;
+
+    for (i = 0; i < c->npanels * nr; i++) {
+        pc   = c->panels + (long)(i / nr) * numCoords * nr + i % nr;
+        norm = 0.0;
+        for (k = 0; k < numCoords; k++) {
+            pc[k * nr] = (i < c->numClusters) ? clusters[(long)i * numCoords + k] : 0.0;
+            norm += pc[k * nr] * pc[k * nr];
+        }
+        // padding centroids can never win the argmin
+        c->norms[i] = (i < c->numClusters) ? norm : DBL_MAX;
+    }
+}
+
+void dist_argmin(const dist_centroids_t* c, const double* objects, int n, int* index,
+                 double* mindist) {
+    int           numCoords = c->numCoords, mr = c->mr;
+    int           i, p, k, cnt, besti[MAX_MR];
+    double        bestv[MAX_MR], tail[MAX_MR * 64], xnorm;
+    double*       buf = tail;
+    const double* x;
+
+    for (i = 0; i < n; i += mr) {
+        cnt = (n - i < mr) ? n - i : mr;
+        x   = objects + (long)i * numCoords;
+        if (cnt < mr) {
+            // zero-pad the last, partial tile
+            if (mr * numCoords > MAX_MR * 64)
+                buf = (typeof(buf))malloc(mr * numCoords * sizeof(*buf));
+            if (!buf) {
+                fprintf(stderr, "Out of memory.\n");
+                exit(1);
+            }
+            memcpy(buf, x, cnt * numCoords * sizeof(*buf));
+            memset(buf + cnt * numCoords, 0, (mr - cnt) * numCoords * sizeof(*buf));
+            x = buf;
+        }
+
+        c->kernel(c, x, bestv, besti);
+
+        for (p = 0; p < cnt; p++)
+            index[i + p] = besti[p];
+        if (mindist) {
+            for (p = 0; p < cnt; p++) {
+                xnorm = 0.0;
+                for (k = 0; k < numCoords; k++)
+                    xnorm += x[p * numCoords + k] * x[p * numCoords + k];
+                mindist[i + p] = (xnorm + bestv[p] > 0.0) ? xnorm + bestv[p] : 0.0;
+            }
+        }
+    }
+    if (buf != tail)
+        free(buf);
+}
@@ -0,0 +1,63 @@
+#ifndef _H_DISTANCE
+#define _H_DISTANCE
+
+/*
+ * Blocked distance engine for the assignment step.
+ *
+ * Instead of computing one point-to-centroid distance at a time, a block of points is compared
+ * against all centroids using
+ *
+ *     ||x - c||^2 = ||x||^2 - 2 x.c + ||c||^2
+ *
+ * The x.c terms form a small matrix product, which is computed by register-blocked
+ * micro-kernels (MR points x NR centroids per tile) over centroids packed in panels of NR.
+ * ||x||^2 is the same for all centroids, so the argmin only needs ||c||^2 - 2 x.c and is fused
+ * into the kernel: the tile is folded into a running minimum as soon as it is computed.
+ *
+ * The expansion loses some precision when points are very close to a centroid compared to their
+ * norms, so memberships may differ from the direct formula on (near) ties.
+ */
+
+typedef struct dist_centroids dist_centroids_t;
+
+typedef void (*dist_kernel_fn)(const dist_centroids_t* c,
+                               const double*           objects, /* [MR][numCoords] */
+                               double*                 bestv,   /* [MR] */
+                               int*                    besti);  /* [MR] */
+
+struct dist_centroids {
+    int            numClusters;
+    int            numCoords;
+    int            mr, nr;  /* tile size of the selected kernel */
+    int            npanels; /* ceil(numClusters / nr) */
+    double*        panels;  /* [npanels][numCoords][nr] */
+    double*        norms;   /* [npanels * nr]: ||c||^2, DBL_MAX for the padding */
+    dist_kernel_fn kernel;
+    const char*    name;
+};
+
+/*
+ * Pick the widest kernel the CPU supports. KMEANS_DIST=avx512|avx2|generic overrides the choice,
+ * and asking for a kernel the CPU does not support is an error (KMEANS_DIST=scalar is handled by
+ * the callers, which then keep the one-distance-at-a-time loop).
+ */
+dist_centroids_t* dist_init(int numClusters, int numCoords);
+void              dist_free(dist_centroids_t* c);
+
+// Repack the centroids and their norms; call it whenever clusters[] changes.
+void dist_pack(dist_centroids_t* c, const double* clusters); /* [numClusters][numCoords] */
+
+/*
+ * Nearest centroid of each of the n points of objects[]. If mindist is not NULL, the squared
+ * distance to it is stored too.
+ */
+void dist_argmin(const dist_centroids_t* c,
+                 const double*           objects, /* [n][numCoords] */
+                 int                     n,
+                 int*                    index,    /* out: [n] */
+                 double*                 mindist); /* out: [n] or NULL */
+
+// Non-zero if the one-distance-at-a-time loop was requested with KMEANS_DIST=scalar.
+int dist_use_scalar(void);
+
+#endif
@@ -10,6 +10,8 @@
     #include <omp.h>
 #endif
 #include "kmeans.h"
+#include "placement.h"
+#include "rng.h"
 
 #ifdef _NUMA_AWARE
 const char numa_aware[] = "NUMA-Aware";
@@ -17,34 +19,41 @@ const char numa_aware[] = "NUMA-Aware";
 const char numa_aware[] = "Non-NUMA-Aware";
 #endif
 
-double* dataset_generation(int numObjs, int numCoords) {
-    double* objects = NULL;
-    long    i, j;
+void dataset_object(long i, int numCoords, double* object) {
+    unsigned long long key = rng_key(DATASET_SEED, 0);
+    int                j;
     // Random values that will be generated will be between 0 and 10.
     double val_range = 10;
 
+    for (j = 0; j < numCoords; j++)
+        object[j] = rng_unit(key, (unsigned long long)i * numCoords + j) * val_range;
+}
+
+double* dataset_generation(int numObjs, int numCoords) {
+    double* objects = NULL;
+    long    i, j, b;
+
     /* allocate space for objects[][] and read all objects */
-    objects = (typeof(objects))malloc(numObjs * numCoords * sizeof(*objects));
+    objects = (typeof(objects))placement_alloc((size_t)numObjs * numCoords * sizeof(*objects));
 
     /*
-     * Hint : Could dataset generation be performed in a more "NUMA-Aware" way?
-     *        Need to place data "close" to the threads that will perform operations on them.
-     *        reminder : First-touch data placement policy
+     * NUMA-aware generation: every object is computed from its index alone (see rng.h), so the
+     * data do not depend on the thread that writes them, and the blocks of objects are distributed
+     * with the same static schedule as the compute loops (see OBJ_BLOCK). Each page is thus first
+     * touched by the thread that will use it.
      */
-
-    for (i = 0; i < numObjs; i++) {
-        unsigned int seed = i;
-
-        // clang-format off
-		#if  defined(_OPENMP) && defined(_NUMA_AWARE)
-			#pragma message "NUMA-Aware dataset generation"
-			#pragma omp parallel for schedule(static) private(j)
-		#endif
-        // clang-format on
-        for (j = 0; j < numCoords; j++) {
-            objects[i * numCoords + j] = (rand_r(&seed) / ((double)RAND_MAX)) * val_range;
+    // clang-format off
+	#if  defined(_OPENMP) && defined(_NUMA_AWARE)
+		#pragma message "NUMA-Aware dataset generation"
+		#pragma omp parallel for schedule(static) private(i, j)
+	#endif
+    // clang-format on
+    for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+        for (i = b; i < b + OBJ_BLOCK && i < numObjs; i++) {
+            dataset_object(i, numCoords, &objects[i * numCoords]);
             if (_debug && i == 0)
-                LOG("object[i=%ld][j=%ld]=%f\n", i, j, objects[i * numCoords + j]);
+                for (j = 0; j < numCoords; j++)
+                    LOG("object[i=%ld][j=%ld]=%f\n", i, j, objects[i * numCoords + j]);
         }
     }
 
@@ -24,6 +24,13 @@
 #endif
 // clang-format on
 
+/*
+ * The parallel loops hand objects to threads in blocks of OBJ_BLOCK with a static schedule. The
+ * NUMA-aware dataset generation uses the same blocks and schedule, so that each thread first
+ * touches the objects it will later process. A multiple of every distance kernel's tile height.
+ */
+#define OBJ_BLOCK 64
+
 void kmeans(double* objects,
             int     numCoords,
             int     numObjs,
@@ -33,8 +40,37 @@ void kmeans(double* objects,
             int*    membership,
             double* clusters);
 
+/*
+ * Non-zero if the kmeans() linked in implements KMEANS_PRECISION and KMEANS_LAYOUT (see
+ * precision.h and layout.h); main.c refuses those variables, and KMEANS_VALIDATE, otherwise.
+ */
+extern const int kmeans_variants;
+
+/*
+ * Mini-batch k-means over a stream of objects (see stream.h and omp_minibatch_kmeans.c): no
+ * membership, and the dataset is never held in memory.
+ */
+struct stream;
+void kmeans_minibatch(struct stream* src,
+                      int            numCoords,
+                      int            numClusters,
+                      int            batchSize,
+                      double         threshold,
+                      long           loop_threshold,
+                      double*        clusters);
+
+/*
+ * Synthetic dataset: coordinate j of object i is draw i * numCoords + j of the counter-based
+ * generator of rng.h (seed DATASET_SEED), scaled to [0, 10). Every object is computed on its own,
+ * so the data are the same whatever generates them: serial or parallel, whole or in slices.
+ */
+#define DATASET_SEED 2024
+
 double* dataset_generation(int numObjs, int numCoords);
 
+// Object i of the generated dataset, computed on its own (dataset_generation() fills every object).
+void dataset_object(long i, int numCoords, double* object);
+
 int check_repeated_clusters(int, int, double*);
 
 double wtime(void);
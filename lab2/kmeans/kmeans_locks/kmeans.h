@@ -11,6 +11,8 @@ int check_repeated_clusters(int, int, double*);
 
 double wtime(void);
 
+int kmeans_stripes(int numClusters);
+
 extern int _debug;
 
 #endif
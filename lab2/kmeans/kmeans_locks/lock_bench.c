@@ -0,0 +1,284 @@
+/*
+ * Lock microbenchmark: nthreads threads repeatedly acquire the same lock,
+ * spend cs_ns in the critical section and outside_ns outside of it.
+ * For every critical section length it reports
+ *   - acquires/sec over all threads,
+ *   - fairness, as the coefficient of variation (stddev / mean) of the
+ *     per-thread acquisition counts, along with their min and max,
+ *   - handoff latency, the time from a release to the next acquisition by
+ *     a different thread. It is measured inside the critical section, which
+ *     therefore grows by two clock reads.
+ * -L picks the locks to run, by default all of them one after the other.
+ * -r sets the percentage of acquisitions in read mode, which only reader-writer
+ * locks can share (see lock.h).
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "lock.h"
+#include "backoff.h"
+
+#define MAX_THREADS  256
+#define MAX_CS_LENS  16
+#define MAX_LOCKS    32
+
+#define print_error_and_exit(format...) \
+    do { \
+        fprintf(stderr, format); \
+        exit(EXIT_FAILURE); \
+    } while (0)
+
+typedef struct {
+    int tid;
+    unsigned long long acquires;
+    unsigned long long reads;
+    unsigned long long handoffs;
+    unsigned long long handoff_ns;
+    unsigned long long handoff_max;
+    char padding[64 - sizeof(int) - 5 * sizeof(unsigned long long)];
+} __attribute__ ((aligned(64))) tdata_t;
+
+/* Data protected by the lock, in its own cache line. */
+struct {
+    unsigned long long counter;
+    unsigned long long last_release_ns;
+    int last_owner;
+} __attribute__ ((aligned(64))) shared;
+
+lock_t *lock;
+int nthreads = 1;
+int read_pct;
+unsigned long cs_iters, outside_iters;
+pthread_barrier_t start_barrier;
+volatile int time_to_leave;
+
+static inline unsigned long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Busy work of a given length. The empty asm statement keeps the compiler
+ * from removing the loop; its speed is measured once to convert ns to
+ * iterations.
+ */
+static inline void work(unsigned long iters)
+{
+    unsigned long i;
+
+    for (i=0; i < iters; i++)
+        __asm__ __volatile__("" ::: "memory");
+}
+
+static double iters_per_ns;
+
+static void work_calibrate(void)
+{
+    unsigned long long t1, t2;
+    unsigned long iters = 10000000;
+
+    t1 = now_ns();
+    work(iters);
+    t2 = now_ns();
+    iters_per_ns = (double)iters / (double)(t2 - t1);
+}
+
+static unsigned long ns_to_iters(unsigned long ns)
+{
+    return (unsigned long)(ns * iters_per_ns + 0.5);
+}
+
+static void *thread_fn(void *arg)
+{
+    tdata_t *me = arg;
+    unsigned int seed = me->tid * 7919 + 1;
+    unsigned long long t, gap;
+    cpu_set_t cpu_set;
+    int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    CPU_ZERO(&cpu_set);
+    CPU_SET(me->tid % ncpus, &cpu_set);
+    sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+
+    pthread_barrier_wait(&start_barrier);
+
+    while (!time_to_leave) {
+        if (read_pct && (int)(rand_r(&seed) % 100) < read_pct) {
+            lock_read_acquire(lock);
+            __asm__ __volatile__("" :: "r"(shared.counter) : "memory");
+            work(cs_iters);
+            lock_read_release(lock);
+            me->acquires++;
+            me->reads++;
+            work(outside_iters);
+            continue;
+        }
+        lock_acquire(lock);
+        t = now_ns();
+        if (shared.last_owner != me->tid && shared.last_release_ns) {
+            gap = t - shared.last_release_ns;
+            me->handoffs++;
+            me->handoff_ns += gap;
+            if (gap > me->handoff_max)
+                me->handoff_max = gap;
+        }
+        shared.counter++;
+        work(cs_iters);
+        shared.last_owner = me->tid;
+        shared.last_release_ns = now_ns();
+        lock_release(lock);
+
+        me->acquires++;
+        work(outside_iters);
+    }
+
+    return NULL;
+}
+
+static void run(const char *id, unsigned long cs_ns, unsigned long outside_ns, int duration_ms)
+{
+    pthread_t threads[MAX_THREADS];
+    tdata_t *tdata;
+    unsigned long long total = 0, reads = 0, handoffs = 0, handoff_ns = 0;
+    unsigned long long handoff_max = 0, min = ~0ULL, max = 0;
+    unsigned long long t1, t2;
+    double mean, var = 0.0, secs;
+    lock_params_t params;
+    int i;
+
+    if (posix_memalign((void **)&tdata, 64, nthreads * sizeof(*tdata)))
+        print_error_and_exit("Out of memory.\n");
+    memset(tdata, 0, nthreads * sizeof(*tdata));
+    memset(&shared, 0, sizeof(shared));
+    shared.last_owner = -1;
+
+    lock_params_from_env(&params);
+    lock = lock_init(id, nthreads, &params);
+    cs_iters = ns_to_iters(cs_ns);
+    outside_iters = ns_to_iters(outside_ns);
+    time_to_leave = 0;
+
+    if (pthread_barrier_init(&start_barrier, NULL, nthreads + 1))
+        print_error_and_exit("Failed to initialize start_barrier.\n");
+    for (i=0; i < nthreads; i++) {
+        tdata[i].tid = i;
+        if (pthread_create(&threads[i], NULL, thread_fn, &tdata[i]))
+            print_error_and_exit("Error creating thread %d.\n", i);
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    t1 = now_ns();
+    usleep(duration_ms * 1000);
+    time_to_leave = 1;
+    for (i=0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    t2 = now_ns();
+    pthread_barrier_destroy(&start_barrier);
+
+    for (i=0; i < nthreads; i++) {
+        total += tdata[i].acquires;
+        reads += tdata[i].reads;
+        handoffs += tdata[i].handoffs;
+        handoff_ns += tdata[i].handoff_ns;
+        if (tdata[i].handoff_max > handoff_max)
+            handoff_max = tdata[i].handoff_max;
+        if (tdata[i].acquires < min)
+            min = tdata[i].acquires;
+        if (tdata[i].acquires > max)
+            max = tdata[i].acquires;
+    }
+    mean = (double)total / nthreads;
+    for (i=0; i < nthreads; i++)
+        var += (tdata[i].acquires - mean) * (tdata[i].acquires - mean);
+    var /= nthreads;
+    secs = (t2 - t1) / 1e9;
+
+    printf("Lock: %s  Nthreads: %d  CS(ns): %lu  Outside(ns): %lu  Reads(%%): %d"
+           "  Acquires/sec: %.1lf  Fairness(CoV): %.4lf  Min: %llu  Max: %llu"
+           "  Handoff(ns): avg %.1lf max %llu  Check: %s\n",
+           lock_name(lock), nthreads, cs_ns, outside_ns, read_pct, total / secs,
+           mean > 0 ? sqrt(var) / mean : 0.0, min, max,
+           handoffs ? (double)handoff_ns / handoffs : 0.0, handoff_max,
+           shared.counter == total - reads ? "OK" : "FAILED");
+
+    lock_free(lock);
+    free(tdata);
+}
+
+static void usage(char *prog)
+{
+    print_error_and_exit("usage: %s [-L lock[,lock...]] [-t nthreads] [-d duration_ms]"
+                         " [-c cs_ns[,cs_ns...]] [-o outside_ns] [-r read_pct]\n"
+                         "  -L locks        lock ids to run (default: all of them)\n"
+                         "  -t nthreads     number of threads (default 1)\n"
+                         "  -d duration_ms  duration of every run (default 1000)\n"
+                         "  -c cs_ns,...    critical section lengths (default 0,100,1000)\n"
+                         "  -o outside_ns   work between acquisitions (default 0)\n"
+                         "  -r read_pct     %% of read acquisitions, shared only by the\n"
+                         "                  reader-writer locks (default 0)\n"
+                         "The wait policy is taken from LOCK_WAIT and friends (see backoff.h).\n",
+                         prog);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long cs_lens[MAX_CS_LENS] = { 0, 100, 1000 };
+    const char *lock_ids[MAX_LOCKS];
+    unsigned long outside_ns = 0;
+    int ncs = 3, nlocks = 0, duration_ms = 1000, opt, i, l;
+    char *tok;
+
+    while ((opt = getopt(argc, argv, "L:t:d:c:o:r:h")) != -1) {
+        switch (opt) {
+        case 'L':
+            for (tok = strtok(optarg, ","); tok && nlocks < MAX_LOCKS; tok = strtok(NULL, ","))
+                lock_ids[nlocks++] = tok;
+            break;
+        case 't':
+            nthreads = atoi(optarg);
+            break;
+        case 'd':
+            duration_ms = atoi(optarg);
+            break;
+        case 'c':
+            ncs = 0;
+            for (tok = strtok(optarg, ","); tok && ncs < MAX_CS_LENS; tok = strtok(NULL, ","))
+                cs_lens[ncs++] = strtoul(tok, NULL, 10);
+            break;
+        case 'o':
+            outside_ns = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            read_pct = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (nthreads < 1 || nthreads > MAX_THREADS)
+        print_error_and_exit("nthreads must be in [1, %d].\n", MAX_THREADS);
+    if (ncs == 0 || duration_ms <= 0 || read_pct < 0 || read_pct > 100)
+        usage(argv[0]);
+    if (!nlocks)
+        for (; lock_id(nlocks) && nlocks < MAX_LOCKS; nlocks++)
+            lock_ids[nlocks] = lock_id(nlocks);
+
+    work_calibrate();
+    for (l=0; l < nlocks; l++)
+        for (i=0; i < ncs; i++)
+            run(lock_ids[l], cs_lens[i], outside_ns, duration_ms);
+
+    return 0;
+}
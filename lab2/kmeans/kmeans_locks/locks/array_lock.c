@@ -1,69 +1,76 @@
 #include "alloc.h"
-#include "lock.h"
-char LOCKNAME[32];
+#include "lock_impl.h"
 
 #define FALSE 0
 #define TRUE  1
 
-#define FLAG_ENTRY_SIZE 1024
+/**
+ * Every slot gets two cache lines, so that waiters on neighbouring slots do
+ * not disturb each other through the adjacent-line prefetcher either.
+ **/
+#define SLOT_SIZE 128
+
+typedef struct {
+	volatile char flag; /* FALSE or TRUE. */
+	char padding[SLOT_SIZE - 1];
+} __attribute__ ((aligned(SLOT_SIZE))) slot_t;
 
 struct lock_struct {
-	volatile char *flag;
-	char padding1[64 - sizeof(char *)];
-	unsigned long long tail;
-	char padding2[64 - sizeof(unsigned long long)];
-	int size;
-};
-
-lock_t *lock_init(int nthreads)
+	slot_t *slots;
+	unsigned long long mask; /* Number of slots - 1, a power of two. */
+	char padding1[SLOT_SIZE - sizeof(slot_t *) - sizeof(unsigned long long)];
+	volatile unsigned long long tail;
+	char padding2[SLOT_SIZE - sizeof(unsigned long long)];
+} __attribute__ ((aligned(SLOT_SIZE)));
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
 {
-	strcpy(LOCKNAME,"array-based");
-	lock_t *lock;
-	int i;
+	strcpy(name,"array-based");
+	impl_t *lock;
+	unsigned long long i, nslots;
 
-	XMALLOC(lock, 1);
+	/* One slot per thread, rounded up so that slot = ticket & mask. */
+	for (nslots=1; nslots < (unsigned long long)nthreads; nslots <<= 1)
+		;
 
-	lock->size = nthreads * FLAG_ENTRY_SIZE;
+	XMALLOC_ALIGNED(lock, 1, SLOT_SIZE);
+	XMALLOC_ALIGNED(lock->slots, nslots, SLOT_SIZE);
+	lock->mask = nslots - 1;
 	lock->tail = 0;
-	XMALLOC(lock->flag, lock->size);
 
-	for (i=0; i < lock->size; i++)
-		lock->flag[i] = FALSE;
-	lock->flag[0] = TRUE;
+	for (i=0; i < nslots; i++)
+		lock->slots[i].flag = FALSE;
+	lock->slots[0].flag = TRUE;
 
-	// printf("lock->size = %d\n", lock->size);
 	return lock;
 }
 
-void lock_free(lock_t *lock)
+static void impl_free(impl_t *lock)
 {
-	lock_t *l = lock;
-	XFREE((void*)l->flag);
+	impl_t *l = lock;
+	XFREE(l->slots);
 	XFREE(l);
 }
 
-__thread int mySlot;
+static __thread unsigned long long mySlot;
 
-void lock_acquire(lock_t *lock)
+static inline void impl_acquire(impl_t *lock)
 {
-	lock_t *l = lock;
-	int slot = __sync_fetch_and_add(&l->tail, FLAG_ENTRY_SIZE) % l->size;
-	
-	mySlot = slot;
-	// if (mySlot < 0) {
-	// printf("mySlot = %d\n", mySlot);
-	// printf("Tail = %d\n", l->tail);
-	// }
+	impl_t *l = lock;
+	unsigned long long slot = __sync_fetch_and_add(&l->tail, 1) & l->mask;
 
-	while (l->flag[slot] == FALSE)
+	mySlot = slot;
+	while (l->slots[slot].flag == FALSE)
 		/* do nothing */ ;
 }
 
-void lock_release(lock_t *lock)
+static inline void impl_release(impl_t *lock)
 {
-	lock_t *l = lock;
-	int slot = mySlot;
+	impl_t *l = lock;
+	unsigned long long slot = mySlot;
 
-	l->flag[slot] = FALSE;
-	l->flag[(slot+FLAG_ENTRY_SIZE) % l->size] = TRUE;
+	l->slots[slot].flag = FALSE;
+	l->slots[(slot + 1) & l->mask].flag = TRUE;
 }
+
+LOCK_IMPLEMENTATION(array)
@@ -0,0 +1,109 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> /* _mm_pause() */
+#endif
+
+#include "lock.h"
+
+/**
+ * Spin-wait hint: tells the cpu we are busy-waiting, which saves power,
+ * frees resources for the sibling hyperthread and avoids the memory-order
+ * mis-speculation penalty when the lock word finally changes.
+ **/
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * Bounded exponential backoff: wait `*delay` pause instructions and double
+ * the delay for the next failed attempt, up to `max`.
+ **/
+static inline void backoff(unsigned int *delay, unsigned int max)
+{
+	unsigned int i;
+
+	for (i=0; i < *delay; i++)
+		cpu_relax();
+	if (*delay < max)
+		*delay = (*delay * 2 < max) ? *delay * 2 : max;
+}
+
+static inline void futex_wait(volatile int *addr, int val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static inline void futex_wake(volatile int *addr, int nr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, nr, NULL, NULL, 0);
+}
+
+/**
+ * Fill in the defaults for a NULL or partially filled lock_params_t.
+ **/
+static inline lock_params_t lock_params_get(const lock_params_t *params)
+{
+	lock_params_t ret = { LOCK_WAIT_SPIN, 0, 0, 0 };
+
+	if (params)
+		ret = *params;
+	if (!ret.backoff_min)
+		ret.backoff_min = 4;
+	if (ret.backoff_max < ret.backoff_min)
+		ret.backoff_max = (ret.backoff_min > 1024) ? ret.backoff_min : 1024;
+	if (!ret.spin_limit)
+		ret.spin_limit = 1000;
+	return ret;
+}
+
+/**
+ * The wait policy of the spinning locks is taken from the environment:
+ *   LOCK_WAIT=spin|backoff|park, LOCK_BACKOFF_MIN, LOCK_BACKOFF_MAX, LOCK_SPIN_LIMIT
+ **/
+static inline void lock_params_from_env(lock_params_t *params)
+{
+	char *e;
+
+	memset(params, 0, sizeof(*params));
+	if ((e = getenv("LOCK_WAIT"))) {
+		if (!strcmp(e, "backoff"))
+			params->wait = LOCK_WAIT_BACKOFF;
+		else if (!strcmp(e, "park"))
+			params->wait = LOCK_WAIT_PARK;
+		else if (strcmp(e, "spin"))
+			fprintf(stderr, "LOCK_WAIT: unknown policy '%s', using spin\n", e);
+	}
+	if ((e = getenv("LOCK_BACKOFF_MIN")))
+		params->backoff_min = atoi(e);
+	if ((e = getenv("LOCK_BACKOFF_MAX")))
+		params->backoff_max = atoi(e);
+	if ((e = getenv("LOCK_SPIN_LIMIT")))
+		params->spin_limit = atoi(e);
+}
+
+static inline const char *lock_wait_name(lock_wait_t wait)
+{
+	switch (wait) {
+	case LOCK_WAIT_BACKOFF:
+		return "backoff";
+	case LOCK_WAIT_PARK:
+		return "park";
+	default:
+		return "spin";
+	}
+}
+
+#endif /* BACKOFF_H */
@@ -1,68 +1,137 @@
 #include "alloc.h"
-#include "lock.h"
-char LOCKNAME[32];
+#include "lock_impl.h"
 
 #define FALSE 0
 #define TRUE  1
 
-#define FLAG_ENTRY_SIZE 1
+#define NODE_SIZE 128
 
 typedef struct {
 	volatile char locked; /* FALSE or TRUE. */
-//	char padding[63];
-	char padding[1023];
-} clh_node_t;
-//} __attribute__ ((aligned(64))) clh_node_t;
+	char padding[NODE_SIZE - 1];
+} __attribute__ ((aligned(NODE_SIZE))) clh_node_t;
+
+/**
+ * The queue node a thread will enqueue next and the predecessor it waits on.
+ * Nodes move between threads (a thread takes over its predecessor's node on
+ * release), so they are tracked per lock and per thread rather than in
+ * __thread variables, and they never leave the pool of the lock. A thread
+ * claims a slot the first time it uses a lock.
+ **/
+typedef struct {
+	clh_node_t *myNode;
+	clh_node_t *myPred;
+	void *volatile owner;
+	char padding[NODE_SIZE - 3 * sizeof(void *)];
+} __attribute__ ((aligned(NODE_SIZE))) clh_thread_t;
 
 struct lock_struct {
-	clh_node_t *tail;
-};
+	clh_node_t *volatile tail;
+	char padding[NODE_SIZE - sizeof(clh_node_t *)];
+	clh_node_t *nodes;     /* [nthreads + 1] */
+	clh_thread_t *threads; /* [nthreads] */
+	int nthreads;
+	unsigned long id;
+} __attribute__ ((aligned(NODE_SIZE)));
 
 /**
- * These are GCC's magic. Per thread variables.
- * They are initialized to 0 ( = NULL).
+ * The address of myIdentity tells threads apart. The slot of the last lock
+ * we used is cached, keyed by a unique lock id rather than its address,
+ * which could be reused after lock_free(). Every thread first tries the
+ * slot of its hint, so with many locks (e.g. one per k-means cluster) a
+ * thread usually finds itself in the same slot of all of them.
  **/
-__thread clh_node_t *myNode;
-__thread clh_node_t *myPred;
+static unsigned long nr_locks;
+static int nr_hints;
+static __thread char myIdentity;
+static __thread unsigned long myLockId;
+static __thread clh_thread_t *myThread;
+static __thread int myHint = -1;
+
+static clh_thread_t *my_thread(impl_t *l)
+{
+	void *me = &myIdentity;
+	int i;
+
+	if (myLockId == l->id)
+		return myThread;
 
-lock_t *lock_init(int nthreads)
+	if (myHint < 0)
+		myHint = __sync_fetch_and_add(&nr_hints, 1);
+	i = myHint % l->nthreads;
+	if (l->threads[i].owner == me ||
+	    (!l->threads[i].owner &&
+	     __sync_bool_compare_and_swap(&l->threads[i].owner, NULL, me)))
+		goto found;
+
+	for (i=0; i < l->nthreads; i++)
+		if (l->threads[i].owner == me)
+			goto found;
+	for (i=0; i < l->nthreads; i++)
+		if (!l->threads[i].owner &&
+		    __sync_bool_compare_and_swap(&l->threads[i].owner, NULL, me))
+			goto found;
+
+	fprintf(stderr, "clh_lock: more threads than the %d given to lock_init()\n",
+	        l->nthreads);
+	exit(1);
+
+found:
+	myLockId = l->id;
+	myThread = &l->threads[i];
+	return myThread;
+}
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
 {
-	strcpy(LOCKNAME,"clh-queue");
-	lock_t *lock;
-	clh_node_t *tail;
+	strcpy(name,"clh-queue");
+	impl_t *lock;
 	int i;
 
-	XMALLOC(lock, 1);
-	XMALLOC(tail, 1);
+	XMALLOC_ALIGNED(lock, 1, NODE_SIZE);
+	XMALLOC_ALIGNED(lock->nodes, nthreads + 1, NODE_SIZE);
+	XMALLOC_ALIGNED(lock->threads, nthreads, NODE_SIZE);
+	lock->nthreads = nthreads;
+	lock->id = __sync_add_and_fetch(&nr_locks, 1);
 
-	lock->tail = tail;
-	lock->tail->locked = FALSE;
+	for (i=0; i <= nthreads; i++)
+		lock->nodes[i].locked = FALSE;
+	for (i=0; i < nthreads; i++) {
+		lock->threads[i].myNode = &lock->nodes[i];
+		lock->threads[i].myPred = NULL;
+		lock->threads[i].owner = NULL;
+	}
+	lock->tail = &lock->nodes[nthreads];
 
 	return lock;
 }
 
-void lock_free(lock_t *lock)
+static void impl_free(impl_t *lock)
 {
-	lock_t *l = lock;
+	impl_t *l = lock;
+	XFREE(l->threads);
+	XFREE(l->nodes);
 	XFREE(l);
 }
 
-void lock_acquire(lock_t *lock)
+static inline void impl_acquire(impl_t *lock)
 {
-	lock_t *l = lock;
-
-	if (!myNode)
-		XMALLOC(myNode, 1);
+	impl_t *l = lock;
+	clh_thread_t *me = my_thread(l);
 
-	myNode->locked = TRUE;
-	myPred = __sync_lock_test_and_set(&l->tail, myNode);
+	me->myNode->locked = TRUE;
+	me->myPred = __sync_lock_test_and_set(&l->tail, me->myNode);
 
-	while (myPred->locked == TRUE)
+	while (me->myPred->locked == TRUE)
 		/* do nothing */ ;
 }
 
-void lock_release(lock_t *lock)
+static inline void impl_release(impl_t *lock)
 {
-	myNode->locked = FALSE;
-	myNode = myPred;
+	clh_thread_t *me = myThread;
+
+	me->myNode->locked = FALSE;
+	me->myNode = me->myPred;
 }
+
+LOCK_IMPLEMENTATION(clh)
@@ -0,0 +1,145 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>  /* sched_getcpu() */
+#include <unistd.h> /* sysconf() */
+
+#include "alloc.h"
+#include "lock_impl.h"
+
+/**
+ * Cohort lock (Dice et al., "Lock Cohorting"): a global ticket lock plus a
+ * local ticket lock per socket. A thread first takes its socket's local lock
+ * and then the global one. On release, if another thread of the same socket
+ * is waiting, the global lock is handed to it along with the local lock, so
+ * the lock (and the data it protects) stays on one socket. HANDOFF_BUDGET
+ * bounds the number of consecutive local handoffs to keep it fair.
+ **/
+#define HANDOFF_BUDGET 64
+
+typedef struct {
+	volatile unsigned int next_ticket;
+	volatile unsigned int now_serving;
+	volatile int global_passed; /* The global lock comes with the local one. */
+	int handoffs;
+	char padding[64 - 4 * sizeof(int)];
+} __attribute__ ((aligned(64))) local_lock_t;
+
+struct lock_struct {
+	volatile unsigned int next_ticket;
+	char padding1[64 - sizeof(unsigned int)];
+	volatile unsigned int now_serving;
+	char padding2[64 - sizeof(unsigned int)];
+	local_lock_t *local; /* [nsockets] */
+	int nsockets;
+	int ncpus;
+	int *cpu_socket; /* [ncpus] */
+} __attribute__ ((aligned(64)));
+
+static __thread int mySocket = -1;
+
+static int read_socket(int cpu)
+{
+	char path[128];
+	FILE *fp;
+	int socket = 0;
+
+	snprintf(path, sizeof(path),
+	         "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+	fp = fopen(path, "r");
+	if (!fp)
+		return 0;
+	if (fscanf(fp, "%d", &socket) != 1 || socket < 0)
+		socket = 0;
+	fclose(fp);
+	return socket;
+}
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
+{
+	strcpy(name,"cohort");
+	impl_t *lock;
+	int i;
+
+	XMALLOC_ALIGNED(lock, 1, 64);
+	lock->next_ticket = 0;
+	lock->now_serving = 0;
+
+	lock->ncpus = sysconf(_SC_NPROCESSORS_CONF);
+	XMALLOC(lock->cpu_socket, lock->ncpus);
+	lock->nsockets = 1;
+	for (i=0; i < lock->ncpus; i++) {
+		lock->cpu_socket[i] = read_socket(i);
+		if (lock->cpu_socket[i] >= lock->nsockets)
+			lock->nsockets = lock->cpu_socket[i] + 1;
+	}
+
+	XMALLOC_ALIGNED(lock->local, lock->nsockets, 64);
+	memset(lock->local, 0, lock->nsockets * sizeof(local_lock_t));
+
+	return lock;
+}
+
+static void impl_free(impl_t *lock)
+{
+	XFREE(lock->local);
+	XFREE(lock->cpu_socket);
+	XFREE(lock);
+}
+
+/**
+ * Threads are expected to be pinned, so the socket is looked up only once.
+ **/
+static inline local_lock_t *my_local_lock(impl_t *l)
+{
+	int cpu;
+
+	if (mySocket < 0) {
+		cpu = sched_getcpu();
+		mySocket = (cpu >= 0 && cpu < l->ncpus) ? l->cpu_socket[cpu] : 0;
+	}
+	return &l->local[mySocket];
+}
+
+static inline void impl_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	local_lock_t *local = my_local_lock(l);
+	unsigned int ticket;
+
+	ticket = __sync_fetch_and_add(&local->next_ticket, 1);
+	while (local->now_serving != ticket)
+		/* do nothing */ ;
+
+	if (local->global_passed) {
+		local->global_passed = 0;
+		return;
+	}
+
+	ticket = __sync_fetch_and_add(&l->next_ticket, 1);
+	while (l->now_serving != ticket)
+		/* do nothing */ ;
+}
+
+static inline void impl_release(impl_t *lock)
+{
+	impl_t *l = lock;
+	local_lock_t *local = my_local_lock(l);
+
+	/* Is anyone else from our socket waiting? Then keep the global lock. */
+	if (local->next_ticket - local->now_serving > 1 &&
+	    local->handoffs < HANDOFF_BUDGET) {
+		local->handoffs++;
+		local->global_passed = 1;
+		__sync_synchronize();
+		local->now_serving++;
+		return;
+	}
+
+	local->handoffs = 0;
+	__sync_synchronize();
+	l->now_serving++;
+	local->now_serving++;
+}
+
+LOCK_IMPLEMENTATION(cohort)
@@ -0,0 +1,107 @@
+#include "alloc.h"
+#include "backoff.h"
+#include "flat_combining.h"
+
+/**
+ * A combiner keeps scanning the slots while it finds new requests, up to
+ * FC_MAX_PASSES times, to make the most of holding the lock.
+ **/
+#define FC_MAX_PASSES 4
+
+typedef struct {
+	int index;
+	const void *arg;
+	volatile int pending; /* Set by the owner, cleared by the combiner. */
+	char padding[64 - 2 * sizeof(int) - sizeof(void *)];
+} __attribute__ ((aligned(64))) fc_slot_t;
+
+struct fc_struct {
+	volatile int lock;
+	char padding1[64 - sizeof(int)];
+
+	/* Only touched by the combiner. */
+	unsigned long long combines;
+	unsigned long long requests;
+	char padding2[64 - 2 * sizeof(unsigned long long)];
+
+	fc_apply_fn apply;
+	void *ctx;
+	fc_slot_t *slots; /* [nthreads] */
+	int nthreads;
+} __attribute__ ((aligned(64)));
+
+fc_t *fc_init(int nthreads, fc_apply_fn apply, void *ctx)
+{
+	fc_t *fc;
+	int i;
+
+	XMALLOC_ALIGNED(fc, 1, 64);
+	XMALLOC_ALIGNED(fc->slots, nthreads, 64);
+	fc->lock = 0;
+	fc->combines = fc->requests = 0;
+	fc->apply = apply;
+	fc->ctx = ctx;
+	fc->nthreads = nthreads;
+	for (i=0; i < nthreads; i++)
+		fc->slots[i].pending = 0;
+
+	return fc;
+}
+
+void fc_free(fc_t *fc)
+{
+	XFREE(fc->slots);
+	XFREE(fc);
+}
+
+static void fc_combine(fc_t *fc)
+{
+	fc_slot_t *slot;
+	int i, pass, found;
+
+	fc->combines++;
+	for (pass=0; pass < FC_MAX_PASSES; pass++) {
+		found = 0;
+		for (i=0; i < fc->nthreads; i++) {
+			slot = &fc->slots[i];
+			if (!__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE))
+				continue;
+			fc->apply(fc->ctx, slot->index, slot->arg);
+			__atomic_store_n(&slot->pending, 0, __ATOMIC_RELEASE);
+			found++;
+		}
+		fc->requests += found;
+		if (!found)
+			break;
+	}
+}
+
+void fc_apply(fc_t *fc, int tid, int index, const void *arg)
+{
+	fc_slot_t *slot = &fc->slots[tid];
+
+	slot->index = index;
+	slot->arg = arg;
+	__atomic_store_n(&slot->pending, 1, __ATOMIC_RELEASE);
+
+	while (1) {
+		if (!fc->lock && __sync_bool_compare_and_swap(&fc->lock, 0, 1)) {
+			/* We are the combiner, our own request is served in the first pass. */
+			fc_combine(fc);
+			__atomic_store_n(&fc->lock, 0, __ATOMIC_RELEASE);
+			return;
+		}
+
+		/* Wait for a combiner to serve us, or for the lock to become free. */
+		while (__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE) && fc->lock)
+			cpu_relax();
+		if (!__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE))
+			return;
+	}
+}
+
+void fc_stats(fc_t *fc, unsigned long long *combines, unsigned long long *requests)
+{
+	*combines = fc->combines;
+	*requests = fc->requests;
+}
@@ -0,0 +1,31 @@
+#ifndef FLAT_COMBINING_H
+#define FLAT_COMBINING_H
+
+/**
+ * Flat combining (Hendler, Incze, Shavit and Tzafrir, "Flat combining and
+ * the synchronization-parallelism tradeoff").
+ * Instead of every thread taking a lock and touching the shared data itself,
+ * threads publish their request `(index, arg)` in a per-thread slot. Whoever
+ * gets the combiner lock applies all the published requests in a batch by
+ * calling `apply(ctx, index, arg)`, so the shared data stays in the cache of
+ * the combiner instead of moving between cores on every update.
+ *
+ * fc_apply() returns once the request has been applied, so `arg` only has to
+ * stay valid until then. `tid` must be in [0, nthreads) and unique among the
+ * threads that use `fc` concurrently (e.g. omp_get_thread_num()).
+ **/
+typedef struct fc_struct fc_t;
+typedef void (*fc_apply_fn)(void *ctx, int index, const void *arg);
+
+fc_t *fc_init(int nthreads, fc_apply_fn apply, void *ctx);
+void fc_free(fc_t *fc);
+
+void fc_apply(fc_t *fc, int tid, int index, const void *arg);
+
+/**
+ * Number of combining rounds and of requests applied so far; their ratio is
+ * the average batch size.
+ **/
+void fc_stats(fc_t *fc, unsigned long long *combines, unsigned long long *requests);
+
+#endif /* FLAT_COMBINING_H */
@@ -0,0 +1,59 @@
+#include "alloc.h"
+#include "lock.h"
+
+/**
+ * Registry of the lock implementations, in the order lock_id() lists them.
+ **/
+extern const lock_ops_t lock_ops_nosync, lock_ops_pthread_mutex, lock_ops_pthread_spin,
+	lock_ops_tas, lock_ops_ttas, lock_ops_array, lock_ops_clh, lock_ops_mcs,
+	lock_ops_cohort, lock_ops_ticket, lock_ops_pf_rw, lock_ops_percpu_rw;
+
+static const lock_ops_t *lock_registry[] = {
+	&lock_ops_nosync,
+	&lock_ops_pthread_mutex,
+	&lock_ops_pthread_spin,
+	&lock_ops_tas,
+	&lock_ops_ttas,
+	&lock_ops_array,
+	&lock_ops_clh,
+	&lock_ops_mcs,
+	&lock_ops_cohort,
+	&lock_ops_ticket,
+	&lock_ops_pf_rw,
+	&lock_ops_percpu_rw,
+};
+
+#define NR_LOCKS ((int)(sizeof(lock_registry) / sizeof(lock_registry[0])))
+
+const char *lock_id(int i)
+{
+	return (i >= 0 && i < NR_LOCKS) ? lock_registry[i]->id : NULL;
+}
+
+lock_t *lock_init(const char *id, int nthreads, const lock_params_t *params)
+{
+	lock_t *lock;
+	int i;
+
+	for (i=0; i < NR_LOCKS; i++)
+		if (id && !strcmp(id, lock_registry[i]->id))
+			break;
+	if (i == NR_LOCKS) {
+		fprintf(stderr, "lock_init: unknown lock '%s', available:", id ? id : "(none)");
+		for (i=0; i < NR_LOCKS; i++)
+			fprintf(stderr, " %s", lock_registry[i]->id);
+		fprintf(stderr, "\n");
+		exit(1);
+	}
+
+	XMALLOC(lock, 1);
+	lock->ops = lock_registry[i];
+	lock->impl = lock->ops->init(nthreads, params, lock->name);
+	return lock;
+}
+
+void lock_free(lock_t *lock)
+{
+	lock->ops->free(lock->impl);
+	XFREE(lock);
+}
@@ -1,14 +1,112 @@
 #ifndef LOCK_H
 #define LOCK_H
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-extern char LOCKNAME[32];
+
+/**
+ * How a thread waits for a busy lock. Only honoured by the locks that spin
+ * on a single word (tas, ttas, and ticket for backoff, which it makes
+ * proportional to its place in line); the rest ignore it.
+ *   LOCK_WAIT_SPIN:    plain spinning (the default).
+ *   LOCK_WAIT_BACKOFF: bounded exponential backoff between attempts, from
+ *                      backoff_min to backoff_max pause instructions.
+ *   LOCK_WAIT_PARK:    spin for spin_limit attempts, then sleep on a futex.
+ * Zero fields get sensible defaults, and so does a NULL lock_params_t.
+ **/
+typedef enum {
+	LOCK_WAIT_SPIN = 0,
+	LOCK_WAIT_BACKOFF,
+	LOCK_WAIT_PARK
+} lock_wait_t;
+
+typedef struct {
+	lock_wait_t wait;
+	unsigned int backoff_min;
+	unsigned int backoff_max;
+	unsigned int spin_limit;
+} lock_params_t;
+
+#define LOCK_NAME_LEN 32
+
+/**
+ * The lock library. Locks are picked by id at runtime:
+ *   lock_t *lock = lock_init("mcs", nthreads, &params);
+ * lock_id(i) enumerates the ids (nosync, pthread_mutex, pthread_spin, tas,
+ * ttas, array, clh, mcs, cohort, ticket, pf_rw, percpu_rw) and lock_name()
+ * gives a descriptive name, e.g. "mcs-queue" or "tas-backoff".
+ * Every lock is allocated cache-line aligned and padded, so that many of
+ * them (e.g. one per k-means cluster) can be used without false sharing.
+ *
+ * lock_acquire()/lock_release() take the lock exclusively. Reader-writer
+ * locks (lock_is_rw()) can also be shared with lock_read_acquire() and
+ * lock_read_release(); the rest take the lock exclusively for those too.
+ * A thread may hold at most one queue-based (array, clh, mcs) or
+ * reader-writer lock at a time.
+ *
+ * By default the operations go through a table of function pointers. When
+ * compiled with -DLOCK_INLINE='"<id>_lock.c"' the chosen implementation is
+ * instead included right here, lock_t is its own type and the operations
+ * are inlined into the caller, at the price of supporting a single lock.
+ **/
+#ifdef LOCK_INLINE
 
 typedef struct lock_struct lock_t;
+#include LOCK_INLINE
+
+static char lock_inline_name[LOCK_NAME_LEN];
+
+static inline lock_t *lock_init(const char *id, int nthreads, const lock_params_t *params)
+{
+	if (id && strcmp(id, lock_impl_id)) {
+		fprintf(stderr, "lock_init: built with the %s lock only, not %s\n", lock_impl_id, id);
+		exit(1);
+	}
+	return impl_init(nthreads, params, lock_inline_name);
+}
 
-lock_t *lock_init(int nthreads);
+static inline void lock_free(lock_t *lock) { impl_free(lock); }
+static inline void lock_acquire(lock_t *lock) { impl_acquire(lock); }
+static inline void lock_release(lock_t *lock) { impl_release(lock); }
+static inline void lock_read_acquire(lock_t *lock) { impl_read_acquire(lock); }
+static inline void lock_read_release(lock_t *lock) { impl_read_release(lock); }
+static inline const char *lock_name(lock_t *lock) { return lock_inline_name; }
+static inline int lock_is_rw(lock_t *lock) { return lock_impl_rw; }
+static inline const char *lock_id(int i) { return i ? NULL : lock_impl_id; }
+
+#else /* !LOCK_INLINE */
+
+typedef struct lock_ops {
+	const char *id;
+	int rw;
+	void *(*init)(int nthreads, const lock_params_t *params, char *name);
+	void (*free)(void *lock);
+	void (*acquire)(void *lock);
+	void (*release)(void *lock);
+	void (*read_acquire)(void *lock);
+	void (*read_release)(void *lock);
+} lock_ops_t;
+
+typedef struct lock {
+	const lock_ops_t *ops;
+	void *impl;
+	char name[LOCK_NAME_LEN];
+} lock_t;
+
+/**
+ * lock_init() exits with the list of available ids if `id` is unknown.
+ **/
+lock_t *lock_init(const char *id, int nthreads, const lock_params_t *params);
 void lock_free(lock_t *lock);
+const char *lock_id(int i); /* NULL past the last lock. */
+
+static inline void lock_acquire(lock_t *lock) { lock->ops->acquire(lock->impl); }
+static inline void lock_release(lock_t *lock) { lock->ops->release(lock->impl); }
+static inline void lock_read_acquire(lock_t *lock) { lock->ops->read_acquire(lock->impl); }
+static inline void lock_read_release(lock_t *lock) { lock->ops->read_release(lock->impl); }
+static inline const char *lock_name(lock_t *lock) { return lock->name; }
+static inline int lock_is_rw(lock_t *lock) { return lock->ops->rw; }
 
-void lock_acquire(lock_t *lock);
-void lock_release(lock_t *lock);
+#endif /* LOCK_INLINE */
 
 #endif /* LOCK_H */
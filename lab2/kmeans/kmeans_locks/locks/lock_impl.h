@@ -0,0 +1,50 @@
+#ifndef LOCK_IMPL_H
+#define LOCK_IMPL_H
+
+/**
+ * Interface between lock.h and the lock implementations (locks/<id>_lock.c).
+ * Every implementation defines `struct lock_struct` and
+ *   static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name);
+ *   static void impl_free(impl_t *lock);
+ *   static inline void impl_acquire(impl_t *lock);
+ *   static inline void impl_release(impl_t *lock);
+ * plus impl_read_acquire() and impl_read_release() for reader-writer locks.
+ * impl_init() stores a descriptive name of at most LOCK_NAME_LEN bytes in
+ * `name`. The file then ends with LOCK_IMPLEMENTATION(<id>), or with
+ * RWLOCK_IMPLEMENTATION(<id>) for reader-writer locks.
+ *
+ * Normally this exports `lock_ops_<id>` for the registry in lock.c. When the
+ * implementation is compiled into its user with LOCK_INLINE (see lock.h) it
+ * only records the id, and lock.h calls the impl_*() functions directly.
+ **/
+#include "lock.h"
+
+typedef struct lock_struct impl_t;
+
+#ifdef LOCK_INLINE
+#define LOCK_REGISTER(id, rw) \
+	static const char lock_impl_id[] = #id; \
+	static const int lock_impl_rw = rw;
+#else
+#define LOCK_REGISTER(id, rw) \
+	static void *id##_init_op(int nthreads, const lock_params_t *params, char *name) \
+	{ return impl_init(nthreads, params, name); } \
+	static void id##_free_op(void *lock) { impl_free(lock); } \
+	static void id##_acquire_op(void *lock) { impl_acquire(lock); } \
+	static void id##_release_op(void *lock) { impl_release(lock); } \
+	static void id##_read_acquire_op(void *lock) { impl_read_acquire(lock); } \
+	static void id##_read_release_op(void *lock) { impl_read_release(lock); } \
+	const lock_ops_t lock_ops_##id = { #id, rw, id##_init_op, id##_free_op, \
+		id##_acquire_op, id##_release_op, id##_read_acquire_op, id##_read_release_op };
+#endif
+
+/* Exclusive locks take the lock exclusively for reading too. */
+#define LOCK_IMPLEMENTATION(id) \
+	static inline void impl_read_acquire(impl_t *lock) { impl_acquire(lock); } \
+	static inline void impl_read_release(impl_t *lock) { impl_release(lock); } \
+	LOCK_REGISTER(id, 0)
+
+#define RWLOCK_IMPLEMENTATION(id) \
+	LOCK_REGISTER(id, 1)
+
+#endif /* LOCK_IMPL_H */
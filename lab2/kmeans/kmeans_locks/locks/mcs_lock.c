@@ -0,0 +1,71 @@
+#include "alloc.h"
+#include "lock_impl.h"
+
+#define FALSE 0
+#define TRUE  1
+
+/**
+ * Every thread spins on its own, cache-line sized, queue node. A thread can
+ * only wait for one MCS lock at a time, so a single node per thread is enough.
+ **/
+typedef struct mcs_node {
+	struct mcs_node *volatile next;
+	volatile char locked; /* FALSE or TRUE. */
+	char padding[64 - sizeof(struct mcs_node *) - sizeof(char)];
+} __attribute__ ((aligned(64))) mcs_node_t;
+
+struct lock_struct {
+	mcs_node_t *volatile tail;
+	char padding[64 - sizeof(mcs_node_t *)];
+} __attribute__ ((aligned(64)));
+
+static __thread mcs_node_t myNode;
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
+{
+	strcpy(name,"mcs-queue");
+	impl_t *lock;
+
+	XMALLOC_ALIGNED(lock, 1, 64);
+	lock->tail = NULL;
+
+	return lock;
+}
+
+static void impl_free(impl_t *lock)
+{
+	XFREE(lock);
+}
+
+static inline void impl_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	mcs_node_t *pred;
+
+	myNode.next = NULL;
+	myNode.locked = TRUE;
+	pred = __sync_lock_test_and_set(&l->tail, &myNode);
+	if (!pred)
+		return;
+
+	pred->next = &myNode;
+	while (myNode.locked == TRUE)
+		/* do nothing */ ;
+}
+
+static inline void impl_release(impl_t *lock)
+{
+	impl_t *l = lock;
+
+	if (!myNode.next) {
+		/* No known successor: try to swing the tail back to empty. */
+		if (__sync_bool_compare_and_swap(&l->tail, &myNode, NULL))
+			return;
+		/* Someone is enqueueing, wait until they link themselves. */
+		while (!myNode.next)
+			/* do nothing */ ;
+	}
+	myNode.next->locked = FALSE;
+}
+
+LOCK_IMPLEMENTATION(mcs)
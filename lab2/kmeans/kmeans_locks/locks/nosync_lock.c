@@ -1,30 +1,31 @@
 #include "alloc.h"
-#include "lock.h"
-char LOCKNAME[32];
+#include "lock_impl.h"
 
 struct lock_struct {
 	/* Nothing useful here, just a placeholder. */
 	int dummy;
 };
 
-lock_t *lock_init(int nthreads)
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
 {
-	strcpy(LOCKNAME,"nosync");
+	strcpy(name,"nosync");
 	/* do nothing */
 	return NULL;
 }
 
-void lock_free(lock_t *lock)
+static void impl_free(impl_t *lock)
 {
 	/* do nothing */
 }
 
-void lock_acquire(lock_t *lock)
+static inline void impl_acquire(impl_t *lock)
 {
 	/* do nothing */
 }
 
-void lock_release(lock_t *lock)
+static inline void impl_release(impl_t *lock)
 {
 	/* do nothing */
 }
+
+LOCK_IMPLEMENTATION(nosync)
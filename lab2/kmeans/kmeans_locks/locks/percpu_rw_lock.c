@@ -0,0 +1,109 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h> /* sched_getcpu() */
+#include <unistd.h>
+
+#include "alloc.h"
+#include "lock_impl.h"
+#include "backoff.h"
+
+/**
+ * Writer-preferring reader-writer lock with a reader counter per cpu, in the
+ * spirit of the Linux "big reader" locks. Readers only increment the counter
+ * of the cpu they run on, so read-mostly workloads do not bounce a shared
+ * cache line around. Writers pay for it: they have to scan every counter.
+ *
+ * A reader increments its counter and then checks `writer`, a writer sets
+ * `writer` and then waits for all counters to drain. The atomic operations
+ * are full barriers, so at least one of the two sees the other and backs off.
+ * Readers back off whenever a writer is present or waiting, so writers are
+ * preferred and a steady stream of writers can starve readers.
+ **/
+typedef struct {
+	volatile int count;
+	char padding[64 - sizeof(int)];
+} __attribute__ ((aligned(64))) reader_counter_t;
+
+struct lock_struct {
+	volatile int writer;
+	char padding[64 - sizeof(int)];
+	reader_counter_t *readers; /* [nr_counters] */
+	int nr_counters;
+} __attribute__ ((aligned(64)));
+
+/* The counter we incremented, we may have migrated before releasing. */
+static __thread reader_counter_t *myCounter;
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
+{
+	strcpy(name,"percpu-rw");
+	impl_t *lock;
+	int i;
+
+	XMALLOC_ALIGNED(lock, 1, 64);
+	lock->writer = 0;
+	lock->nr_counters = sysconf(_SC_NPROCESSORS_CONF);
+	if (lock->nr_counters < 1)
+		lock->nr_counters = 1;
+	XMALLOC_ALIGNED(lock->readers, lock->nr_counters, 64);
+	for (i=0; i < lock->nr_counters; i++)
+		lock->readers[i].count = 0;
+	return lock;
+}
+
+static void impl_free(impl_t *lock)
+{
+	impl_t *l = lock;
+	XFREE(l->readers);
+	XFREE(l);
+}
+
+static inline void impl_read_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	int cpu = sched_getcpu();
+	reader_counter_t *c;
+
+	if (cpu < 0)
+		cpu = 0;
+	c = &l->readers[cpu % l->nr_counters];
+	myCounter = c;
+
+	while (1) {
+		__sync_fetch_and_add(&c->count, 1);
+		if (!l->writer)
+			return;
+		/* A writer is in or waiting, get out of its way. */
+		__sync_fetch_and_sub(&c->count, 1);
+		while (l->writer)
+			cpu_relax();
+	}
+}
+
+static inline void impl_read_release(impl_t *lock)
+{
+	__sync_fetch_and_sub(&myCounter->count, 1);
+}
+
+static inline void impl_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	int i;
+
+	while (!__sync_bool_compare_and_swap(&l->writer, 0, 1))
+		cpu_relax();
+
+	for (i=0; i < l->nr_counters; i++)
+		while (l->readers[i].count)
+			cpu_relax();
+}
+
+static inline void impl_release(impl_t *lock)
+{
+	impl_t *l = lock;
+
+	__atomic_store_n(&l->writer, 0, __ATOMIC_RELEASE);
+}
+
+RWLOCK_IMPLEMENTATION(percpu_rw)
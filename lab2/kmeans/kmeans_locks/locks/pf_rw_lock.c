@@ -0,0 +1,91 @@
+#include "alloc.h"
+#include "lock_impl.h"
+#include "backoff.h"
+
+/**
+ * Phase-fair ticket reader-writer lock (Brandenburg and Anderson, "Spin-based
+ * reader-writer synchronization for multiprocessor real-time systems").
+ * Reader and writer phases alternate: a writer waits at most for the readers
+ * that arrived before it, and readers arriving while a writer is present or
+ * waiting go after it, but before any later writer. Neither side starves.
+ *
+ * `rin`/`rout` count arriving and departing readers in units of RINC. The
+ * two low bits of `rin` hold the writer state: PRES is set while a writer is
+ * present and PHID alternates between consecutive writers, so that blocked
+ * readers can tell when the writer they waited for has left.
+ * `win`/`wout` form a ticket lock among writers.
+ **/
+#define RINC  0x100U
+#define WBITS 0x3U
+#define PRES  0x2U
+#define PHID  0x1U
+
+struct lock_struct {
+	volatile unsigned int rin;
+	char padding1[64 - sizeof(unsigned int)];
+	volatile unsigned int rout;
+	char padding2[64 - sizeof(unsigned int)];
+	volatile unsigned int win;
+	char padding3[64 - sizeof(unsigned int)];
+	volatile unsigned int wout;
+	char padding4[64 - sizeof(unsigned int)];
+} __attribute__ ((aligned(64)));
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
+{
+	strcpy(name,"phase-fair-rw");
+	impl_t *lock;
+
+	XMALLOC_ALIGNED(lock, 1, 64);
+	lock->rin = lock->rout = 0;
+	lock->win = lock->wout = 0;
+	return lock;
+}
+
+static void impl_free(impl_t *lock)
+{
+	XFREE(lock);
+}
+
+static inline void impl_read_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	unsigned int w = __sync_fetch_and_add(&l->rin, RINC) & WBITS;
+
+	/* Wait for the current writer to finish, i.e. for its bits to change. */
+	if (w)
+		while ((l->rin & WBITS) == w)
+			cpu_relax();
+}
+
+static inline void impl_read_release(impl_t *lock)
+{
+	impl_t *l = lock;
+
+	__sync_fetch_and_add(&l->rout, RINC);
+}
+
+static inline void impl_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	unsigned int ticket, readers;
+
+	ticket = __sync_fetch_and_add(&l->win, 1);
+	while (l->wout != ticket)
+		cpu_relax();
+
+	/* Announce ourselves and wait for the readers already inside. */
+	readers = __sync_fetch_and_add(&l->rin, PRES | (ticket & PHID));
+	while (l->rout != readers)
+		cpu_relax();
+}
+
+static inline void impl_release(impl_t *lock)
+{
+	impl_t *l = lock;
+
+	__sync_fetch_and_and(&l->rin, ~WBITS);
+	__atomic_store_n(&l->wout, l->wout + 1, __ATOMIC_RELEASE);
+}
+
+RWLOCK_IMPLEMENTATION(pf_rw)
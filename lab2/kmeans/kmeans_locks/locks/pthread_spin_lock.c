@@ -1,38 +1,39 @@
 #include <pthread.h>
 
 #include "alloc.h"
-#include "lock.h"
-char LOCKNAME[32];
+#include "lock_impl.h"
 
 struct lock_struct {
 	pthread_spinlock_t spinlock;
-};
+} __attribute__ ((aligned(64)));
 
-lock_t *lock_init(int nthreads)
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
 {
-	strcpy(LOCKNAME,"pthread-spinlock");
-	lock_t *lock;
+	strcpy(name,"pthread-spinlock");
+	impl_t *lock;
 
-	XMALLOC(lock, 1);
+	XMALLOC_ALIGNED(lock, 1, 64);
 	pthread_spin_init(&lock->spinlock, PTHREAD_PROCESS_SHARED);
 	return lock;
 }
 
-void lock_free(lock_t *lock)
+static void impl_free(impl_t *lock)
 {
 	pthread_spin_destroy(&lock->spinlock);
 	XFREE(lock);
 }
 
-void lock_acquire(lock_t *lock)
+static inline void impl_acquire(impl_t *lock)
 {
-	lock_t *l = lock;
+	impl_t *l = lock;
 
 	pthread_spin_lock(&lock->spinlock);
 }
 
-void lock_release(lock_t *lock)
+static inline void impl_release(impl_t *lock)
 {
-	lock_t *l = lock;
+	impl_t *l = lock;
 	pthread_spin_unlock(&lock->spinlock);
 }
+
+LOCK_IMPLEMENTATION(pthread_spin)
@@ -1,42 +1,87 @@
 #include "alloc.h"
-#include "lock.h"
-char LOCKNAME[32];
+#include "lock_impl.h"
+#include "backoff.h"
 
 typedef enum {
 	UNLOCKED = 0,
-	LOCKED
+	LOCKED,
+	LOCKED_WAITERS /* Only in LOCK_WAIT_PARK mode: someone sleeps on the futex. */
 } lock_state_t;
 
 struct lock_struct {
-	lock_state_t state;
-};
+	volatile int state; /* lock_state_t, an int so that it can be a futex. */
+	lock_params_t params;
+} __attribute__ ((aligned(64)));
 
-lock_t *lock_init(int nthreads)
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
 {
-	strcpy(LOCKNAME,"tas");
-	lock_t *lock;
+	impl_t *lock;
 
-	XMALLOC(lock, 1);
+	XMALLOC_ALIGNED(lock, 1, 64);
 	lock->state = UNLOCKED;
+	lock->params = lock_params_get(params);
+
+	if (lock->params.wait == LOCK_WAIT_SPIN)
+		strcpy(name,"tas");
+	else
+		snprintf(name, LOCK_NAME_LEN, "tas-%s", lock_wait_name(lock->params.wait));
 	return lock;
 }
 
-void lock_free(lock_t *lock)
+static void impl_free(impl_t *lock)
 {
 	XFREE(lock);
 }
 
-void lock_acquire(lock_t *lock)
+/**
+ * Spin for a while, then mark the lock as contended and go to sleep until
+ * the holder wakes us up (Drepper, "Futexes Are Tricky", mutex2).
+ **/
+static void lock_acquire_park(impl_t *l)
+{
+	unsigned int i;
+
+	for (i=0; i < l->params.spin_limit; i++) {
+		if (__sync_bool_compare_and_swap(&l->state, UNLOCKED, LOCKED))
+			return;
+		cpu_relax();
+	}
+
+	while (__sync_lock_test_and_set(&l->state, LOCKED_WAITERS) != UNLOCKED)
+		futex_wait(&l->state, LOCKED_WAITERS);
+}
+
+static inline void impl_acquire(impl_t *lock)
 {
-	lock_t *l = lock;
+	impl_t *l = lock;
+	unsigned int delay = l->params.backoff_min;
 
-	while (__sync_lock_test_and_set(&l->state, LOCKED) == LOCKED)
-		/* do nothing */ ;
+	switch (l->params.wait) {
+	case LOCK_WAIT_BACKOFF:
+		while (__sync_lock_test_and_set(&l->state, LOCKED) == LOCKED)
+			backoff(&delay, l->params.backoff_max);
+		break;
+	case LOCK_WAIT_PARK:
+		lock_acquire_park(l);
+		break;
+	default:
+		while (__sync_lock_test_and_set(&l->state, LOCKED) == LOCKED)
+			cpu_relax();
+		break;
+	}
 }
 
-void lock_release(lock_t *lock)
+static inline void impl_release(impl_t *lock)
 {
-	lock_t *l = lock;
+	impl_t *l = lock;
+
+	if (l->params.wait == LOCK_WAIT_PARK) {
+		if (__sync_lock_test_and_set(&l->state, UNLOCKED) == LOCKED_WAITERS)
+			futex_wake(&l->state, 1);
+		return;
+	}
 
 	__sync_lock_release(&l->state);
 }
+
+LOCK_IMPLEMENTATION(tas)
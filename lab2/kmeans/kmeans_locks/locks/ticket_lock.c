@@ -0,0 +1,65 @@
+#include "alloc.h"
+#include "lock_impl.h"
+#include "backoff.h"
+
+/**
+ * Threads take a ticket and wait until `owner` reaches it, so the lock is
+ * granted in FIFO order. The two counters live in different cache lines:
+ * arriving threads only touch `next`, waiting ones only read `owner`.
+ **/
+struct lock_struct {
+	volatile unsigned int next;
+	char padding1[64 - sizeof(unsigned int)];
+	volatile unsigned int owner;
+	char padding2[64 - sizeof(unsigned int)];
+	lock_params_t params;
+} __attribute__ ((aligned(64)));
+
+static impl_t *impl_init(int nthreads, const lock_params_t *params, char *name)
+{
+	impl_t *lock;
+
+	XMALLOC_ALIGNED(lock, 1, 64);
+	lock->next = 0;
+	lock->owner = 0;
+	lock->params = lock_params_get(params);
+
+	if (lock->params.wait == LOCK_WAIT_BACKOFF)
+		strcpy(name,"ticket-backoff");
+	else
+		strcpy(name,"ticket");
+	return lock;
+}
+
+static void impl_free(impl_t *lock)
+{
+	XFREE(lock);
+}
+
+static inline void impl_acquire(impl_t *lock)
+{
+	impl_t *l = lock;
+	unsigned int ticket = __sync_fetch_and_add(&l->next, 1);
+	unsigned int ahead, i;
+
+	if (l->params.wait != LOCK_WAIT_BACKOFF) {
+		while (l->owner != ticket)
+			cpu_relax();
+		return;
+	}
+
+	/* Proportional backoff: wait longer the further back in line we are. */
+	while ((ahead = ticket - l->owner) != 0)
+		for (i=0; i < ahead * l->params.backoff_min; i++)
+			cpu_relax();
+}
+
+static inline void impl_release(impl_t *lock)
+{
+	impl_t *l = lock;
+
+	/* Only the holder writes `owner`, no atomic read-modify-write needed. */
+	__atomic_store_n(&l->owner, l->owner + 1, __ATOMIC_RELEASE);
+}
+
+LOCK_IMPLEMENTATION(ticket)
@@ -6,6 +6,12 @@
  */ 
 #include <omp.h>
 
+// an OpenMP lock in a cache line of its own
+typedef struct {
+    omp_lock_t lock;
+    char padding[64 - sizeof(omp_lock_t)];
+} __attribute__ ((aligned(64))) padded_omp_lock_t;
+
 // square of Euclid distance between two multi-dimensional points
 inline static double euclid_dist_2(int    numdims,  /* no. dimensions */
                                  double * coord1,   /* [numdims] */
@@ -60,17 +66,41 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
     int * newClusterSize; // [numClusters]: no. objects assigned in each new cluster 
     double * newClusters;  // [numClusters][numCoords] 
     int nthreads;         // no. threads 
+    int nstripes;         // no. locks, 1 means a single critical section
+    int rowStride = numCoords, sizeStride = 1;
+    padded_omp_lock_t * locks = NULL; // [nstripes], cluster i is protected by locks[i % nstripes]
 
     nthreads = omp_get_max_threads();
+    nstripes = kmeans_stripes(numClusters);
     printf("OpenMP Kmeans - Naive-critical\t(number of threads: %d)\n", nthreads);
 
+    // an anonymous critical section cannot be split, striping needs OpenMP locks
+    if (nstripes > 1) {
+        printf("\tstriped locks: %d (%d clusters)\n", nstripes, numClusters);
+        if (posix_memalign((void **)&locks, 64, nstripes * sizeof(*locks))) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        for (i=0; i<nstripes; i++)
+            omp_init_lock(&locks[i].lock);
+    }
+
     // initialize membership
     for (i=0; i<numObjs; i++)
         membership[i] = -1;
 
-    // initialize newClusterSize and newClusters to all 0 
-    newClusterSize = (typeof(newClusterSize)) calloc(numClusters, sizeof(*newClusterSize));
-    newClusters = (typeof(newClusters))  calloc(numClusters * numCoords, sizeof(*newClusters));
+    // initialize newClusterSize and newClusters (zeroed at the start of every loop)
+    // with striped locks every cluster gets its own cache lines, so that
+    // updates under different locks do not false share
+    if (nstripes > 1) {
+        rowStride = (numCoords + 7) & ~7;
+        sizeStride = 64 / sizeof(*newClusterSize);
+    }
+    if (posix_memalign((void **)&newClusterSize, 64, numClusters * sizeStride * sizeof(*newClusterSize)) ||
+        posix_memalign((void **)&newClusters, 64, numClusters * rowStride * sizeof(*newClusters))) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
 
     timing = wtime();
     
@@ -78,8 +108,8 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
         // before each loop, set cluster data to 0
         for (i=0; i<numClusters; i++) {
             for (j=0; j<numCoords; j++)
-                newClusters[i*numCoords + j] = 0.0;
-            newClusterSize[i] = 0;
+                newClusters[i*rowStride + j] = 0.0;
+            newClusterSize[i*sizeStride] = 0;
         }
 
         delta = 0.0;
@@ -90,7 +120,7 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
         #pragma omp parallel for \
         private(i,j,index) \
         firstprivate(numObjs,numClusters,numCoords) \
-        shared(objects,clusters,membership,newClusters,newClusterSize) \
+        shared(objects,clusters,membership,newClusters,newClusterSize,locks) \
         schedule(static) reduction(+:delta)
 
         for (i=0; i<numObjs; i++) {
@@ -117,6 +147,14 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
             //     #pragma omp atomic
             //     newClusters[index*numCoords + j] += objects[i*numCoords + j];
             // }
+            if (nstripes > 1) {
+                omp_set_lock(&locks[index % nstripes].lock);
+                newClusterSize[index*sizeStride]++;
+                for (j=0; j<numCoords; j++)
+                    newClusters[index*rowStride + j] += objects[i*numCoords + j];
+                omp_unset_lock(&locks[index % nstripes].lock);
+                continue;
+            }
             #pragma omp critical
             {
                 newClusterSize[index]++;
@@ -128,9 +166,9 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
 
         // average the sum and replace old cluster centers with newClusters 
         for (i=0; i<numClusters; i++) {
-            if (newClusterSize[i] > 0) {
+            if (newClusterSize[i*sizeStride] > 0) {
                 for (j=0; j<numCoords; j++) {
-                    clusters[i*numCoords + j] = newClusters[i*numCoords + j] / newClusterSize[i];
+                    clusters[i*numCoords + j] = newClusters[i*rowStride + j] / newClusterSize[i*sizeStride];
                 }
             }
         }
@@ -147,4 +185,9 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
 
     free(newClusters);
     free(newClusterSize);
+    if (locks) {
+        for (i=0; i<nstripes; i++)
+            omp_destroy_lock(&locks[i].lock);
+        free(locks);
+    }
 }
@@ -1,12 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "kmeans.h"
 /*
  * TODO: include openmp header file
  */ 
 #include <omp.h>
 
+/*
+ * The lock is picked with LOCK=<id> (see locks/lock.h), except in the
+ * kmeans_omp_<id>_lock builds, which have a single lock compiled in.
+ */
 #include "lock.h"
+#include "backoff.h" /* lock_params_from_env() */
 
 // square of Euclid distance between two multi-dimensional points
 inline static double euclid_dist_2(int    numdims,  /* no. dimensions */
@@ -62,20 +68,38 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
     int * newClusterSize; // [numClusters]: no. objects assigned in each new cluster 
     double * newClusters;  // [numClusters][numCoords] 
     int nthreads;         // no. threads 
+    int nstripes;         // no. locks, cluster i is protected by locks[i % nstripes]
+    int rowStride = numCoords, sizeStride = 1;
 
     nthreads = omp_get_max_threads();
-    lock_t *lock; // lock1 -> newClustersSize, lock2 -> newClusters
-    lock = lock_init(nthreads);
-
-    printf("OpenMP Kmeans - Lock (%s)\t(number of threads: %d)\n", LOCKNAME, nthreads);
+    nstripes = kmeans_stripes(numClusters);
+    lock_params_t lock_params;
+    lock_t **locks;
+    lock_params_from_env(&lock_params);
+    locks = (typeof(locks)) malloc(nstripes * sizeof(*locks));
+    for (i=0; i<nstripes; i++)
+        locks[i] = lock_init(getenv("LOCK"), nthreads, &lock_params);
+
+    printf("OpenMP Kmeans - Lock (%s)\t(number of threads: %d)\n", lock_name(locks[0]), nthreads);
+    if (nstripes > 1)
+        printf("\tstriped locks: %d (%d clusters)\n", nstripes, numClusters);
 
     // initialize membership
     for (i=0; i<numObjs; i++)
         membership[i] = -1;
 
-    // initialize newClus-s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1 >> ./results/kmeans_array_lock.outterSize and newClusters to all 0 
-    newClusterSize = (typeof(newClusterSize)) calloc(numClusters, sizeof(*newClusterSize));
-    newClusters = (typeof(newClusters))  calloc(numClusters * numCoords, sizeof(*newClusters));
+    // initialize newClusterSize and newClusters (zeroed at the start of every loop)
+    // with striped locks every cluster gets its own cache lines, so that
+    // updates under different locks do not false share
+    if (nstripes > 1) {
+        rowStride = (numCoords + 7) & ~7;
+        sizeStride = 64 / sizeof(*newClusterSize);
+    }
+    if (posix_memalign((void **)&newClusterSize, 64, numClusters * sizeStride * sizeof(*newClusterSize)) ||
+        posix_memalign((void **)&newClusters, 64, numClusters * rowStride * sizeof(*newClusters))) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
 
     timing = wtime();
     
@@ -83,8 +107,8 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
         // before each loop, set cluster data to 0
         for (i=0; i<numClusters; i++) {
             for (j=0; j<numCoords; j++)
-                newClusters[i*numCoords + j] = 0.0;
-            newClusterSize[i] = 0;
+                newClusters[i*rowStride + j] = 0.0;
+            newClusterSize[i*sizeStride] = 0;
         }
 
         delta = 0.0;
@@ -95,7 +119,7 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
         #pragma omp parallel for \
         private(i,j,index) \
         firstprivate(numObjs,numClusters,numCoords) \
-        shared(objects,clusters,membership,newClusters,newClusterSize) \
+        shared(objects,clusters,membership,newClusters,newClusterSize,locks) \
         schedule(static) reduction(+:delta)
 
         for (i=0; i<numObjs; i++) {
@@ -110,19 +134,19 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
             membership[i] = index;
 
             // update new cluster centers : sum of objects located within 
-            lock_acquire(lock);
-            newClusterSize[index]++;
+            lock_acquire(locks[index % nstripes]);
+            newClusterSize[index*sizeStride]++;
             for (j=0; j<numCoords; j++){
-                newClusters[index*numCoords + j] += objects[i*numCoords + j];
+                newClusters[index*rowStride + j] += objects[i*numCoords + j];
             }
-            lock_release(lock);
+            lock_release(locks[index % nstripes]);
         }
 
         // average the sum and replace old cluster centers with newClusters 
         for (i=0; i<numClusters; i++) {
-            if (newClusterSize[i] > 0) {
+            if (newClusterSize[i*sizeStride] > 0) {
                 for (j=0; j<numCoords; j++) {
-                    clusters[i*numCoords + j] = newClusters[i*numCoords + j] / newClusterSize[i];
+                    clusters[i*numCoords + j] = newClusters[i*rowStride + j] / newClusterSize[i*sizeStride];
                 }
             }
         }
@@ -140,5 +164,7 @@ void kmeans(double * objects,          /* in: [numObjs][numCoords] */
     free(newClusters);
     free(newClusterSize);
 
-    lock_free(lock);
+    for (i=0; i<nstripes; i++)
+        lock_free(locks[i]);
+    free(locks);
 }
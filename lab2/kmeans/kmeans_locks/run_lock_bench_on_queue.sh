@@ -0,0 +1,32 @@
+#!/bin/bash
+
+## Give the Job a descriptive name
+#PBS -N run_lock_bench
+
+## Output and error files
+#PBS -o run_lock_bench.out
+#PBS -e run_lock_bench.err
+
+## How many machines should we get? 
+#PBS -l nodes=1:ppn=64
+
+##How long should the job run for?
+#PBS -l walltime=00:40:00
+
+## Start 
+## Run make in the src folder (modify properly)
+
+cd /home/parallel/parlab17/a2/kmeans/kmeans_locks
+THREADS=(1 2 4 8 16 32 64)
+CS_LENS=0,100,1000,10000
+DURATION_MS=1000
+READ_PCTS=(0 50 90 99)
+
+mkdir -p ./results
+
+## Every lock of the library is run by the same binary, one after the other.
+for thread_num in "${THREADS[@]}"; do
+	for reads in "${READ_PCTS[@]}"; do
+		./lock_bench -t $thread_num -d $DURATION_MS -c $CS_LENS -r $reads 1>>./results/lock_bench.out
+	done
+done
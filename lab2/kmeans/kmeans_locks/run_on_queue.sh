@@ -23,6 +23,9 @@ SIZE=32
 COORDS=16
 CLUSTERS=32
 LOOPS=10
+WAIT_POLICIES=(spin backoff park)
+STRIPES=(4 cluster)
+STRIPED_LOCKS=(critical nosync_lock pthread_mutex_lock pthread_spin_lock tas_lock ttas_lock array_lock clh_lock mcs_lock cohort_lock ticket_lock)
 
 
 mkdir -p ./results
@@ -36,7 +39,23 @@ for thread_num in "${THREADS[@]}"; do
 	./kmeans_omp_pthread_spin_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_pthread_spin_lock.out         
 	./kmeans_omp_clh_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_clh_lock.out
 	./kmeans_omp_nosync_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_no_sync_lock.out
-	./kmeans_omp_tas_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_tas_lock.out
 	./kmeans_omp_pthread_mutex_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_pthread_mutex_lock.out
-	./kmeans_omp_ttas_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_ttas_lock.out
+	./kmeans_omp_mcs_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_mcs_lock.out
+	./kmeans_omp_cohort_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_cohort_lock.out
+	./kmeans_omp_ticket_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_ticket_lock.out
+	./kmeans_omp_fc -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_fc.out
+
+	## Sweep the wait policies of the spinning locks (see locks/lock.h).
+	for policy in "${WAIT_POLICIES[@]}"; do
+		if [ "$policy" = "spin" ]; then suffix=""; else suffix="_$policy"; fi
+		LOCK_WAIT=$policy ./kmeans_omp_tas_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_tas_lock$suffix.out
+		LOCK_WAIT=$policy ./kmeans_omp_ttas_lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_ttas_lock$suffix.out
+	done
+
+	## Per-cluster (or per-stripe) locks instead of a single one.
+	for stripes in "${STRIPES[@]}"; do
+		for lock in "${STRIPED_LOCKS[@]}"; do
+			KMEANS_STRIPES=$stripes ./kmeans_omp_$lock -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/kmeans_${lock}_stripes_$stripes.out
+		done
+	done
 done
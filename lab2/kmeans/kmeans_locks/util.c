@@ -81,3 +81,21 @@ double wtime(void)
                ((double)etstart.tv_usec) / 1000000.0;  // in microseconds
     return now_time;
 }
+
+/*
+ * Number of locks protecting the newClusters/newClusterSize update in the
+ * lock-based versions, taken from KMEANS_STRIPES: 1 (the default) is a single
+ * lock, n > 1 protects cluster i with lock i % n, and 0, "cluster" or anything
+ * above numClusters gives one lock per cluster.
+ */
+int kmeans_stripes(int numClusters)
+{
+    char *e = getenv("KMEANS_STRIPES");
+    int n = 1;
+
+    if (e)
+        n = atoi(e);
+    if (n <= 0 || n > numClusters)
+        n = numClusters;
+    return n;
+}
@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "layout.h"
+
+static const char* layout_names[] = { "aos", "soa" };
+
+static int      layout_known;
+static layout_t layout;
+
+layout_t layout_get(void) {
+    char* env;
+    int   i;
+
+    if (layout_known)
+        return layout;
+
+    layout_known = 1;
+    layout       = LAYOUT_AOS;
+    if (!(env = getenv("KMEANS_LAYOUT")))
+        return layout;
+    for (i = 0; i < (int)(sizeof(layout_names) / sizeof(layout_names[0])); i++) {
+        if (!strcmp(env, layout_names[i])) {
+            layout = (layout_t)i;
+            return layout;
+        }
+    }
+    fprintf(stderr, "Unknown KMEANS_LAYOUT '%s' (aos or soa).\n", env);
+    exit(1);
+}
+
+void layout_set(layout_t l) {
+    layout_known = 1;
+    layout       = l;
+}
+
+const char* layout_name(layout_t l) {
+    return layout_names[l];
+}
@@ -0,0 +1,49 @@
+#ifndef _H_LAYOUT
+#define _H_LAYOUT
+
+/*
+ * Memory layout of the objects in the reduction k-means, picked with KMEANS_LAYOUT=aos|soa
+ * (default aos):
+ *
+ *  - aos: objects[numObjs][numCoords], as generated and loaded; distances are vectorised across
+ *         coordinates or, in the blocked engine of distance.h, across centroids.
+ *  - soa: the objects are transposed once to dimObjects[numCoords][numObjs], the layout of
+ *         lab3/cuda_kmeans_transpose.cu, and the distances of a block of consecutive objects to
+ *         one centroid are computed together, vectorised across the objects. Every SIMD lane does
+ *         useful work whatever numCoords is, so this helps most for small numCoords (1-8), where
+ *         vectorising across coordinates fails. The direct formula is used, so memberships match
+ *         KMEANS_DIST=scalar exactly.
+ *
+ * soa is double precision without bounds: KMEANS_LAYOUT=soa together with KMEANS_BOUNDS or
+ * KMEANS_PRECISION=float|float-kahan is an error. The transposed copy takes as much memory as the
+ * objects themselves. KMEANS_VALIDATE (see precision.h) checks the soa result against the aos
+ * one.
+ */
+
+typedef enum { LAYOUT_AOS = 0, LAYOUT_SOA } layout_t;
+
+layout_t    layout_get(void);
+void        layout_set(layout_t l); // overrides KMEANS_LAYOUT
+const char* layout_name(layout_t l);
+
+/*
+ * dimObjects[j][i] = objects[i][j], in parallel. Each thread transposes the blocks of OBJ_BLOCK
+ * objects the compute loops give it (first touch), in tiles of OBJ_BLOCK objects by 8
+ * coordinates, so that both the rows read and the cache lines written stay in L1.
+ */
+void layout_transpose(const double* objects,    /* in: [numObjs][numCoords] */
+                      int           numObjs,
+                      int           numCoords,
+                      double*       dimObjects); /* out: [numCoords][numObjs] */
+
+// The soa path of kmeans() in omp_soa_kmeans.c.
+void kmeans_soa(double* objects,
+                int     numCoords,
+                int     numObjs,
+                int     numClusters,
+                double  threshold,
+                long    loop_threshold,
+                int*    membership,
+                double* clusters);
+
+#endif
@@ -7,15 +7,23 @@
 #include <unistd.h>    /* getopt() */
 
 int _debug;
+#include "dataset.h"
 #include "kmeans.h"
+#include "layout.h"
+#include "placement.h"
+#include "precision.h"
+#include "seeding.h"
 
 static void usage(char* argv0) {
     char* help = "Usage: %s [switches]\n"
                  "       -c num_clusters    : number of clusters (must be > 1)\n"
                  "       -s size            : size of examined dataset\n"
                  "       -n num_coords      : number of coordinates\n"
+                 "       -f file            : cluster a binary dataset (see dataset.h) instead of\n"
+                 "                            generating -s/-n random data\n"
                  "       -t threshold       : threshold value (default : 0.001)\n"
                  "       -l loop_threshold  : iterations threshold (default : 10)\n"
+                 "       -i init            : initial centers, first|kmeans++|kmeans|| (default : first)\n"
                  "       -d                 : enable debug mode\n"
                  "       -h                 : print this help information\n";
     fprintf(stderr, help, argv0);
@@ -27,13 +35,18 @@ int main(int argc, char** argv) {
     extern char* optarg;
     extern int   optind;
 
-    long    numClusters = 0, numCoords = 0, numObjs = 0;
-    int*    membership; // [numObjs]
-    double* objects;    // [numObjs * numCoords] data  objects
-    double* clusters;   // [numClusters * numCoords] cluster center
-    double  dataset_size = 0, threshold;
-    long    loop_threshold;
-    double  io_timing_read;
+    long       numClusters = 0, numCoords = 0, numObjs = 0;
+    int*       membership; // [numObjs]
+    double*    objects;    // [numObjs * numCoords] data  objects
+    double*    clusters;   // [numClusters * numCoords] cluster center
+    double     dataset_size = 0, threshold;
+    long       loop_threshold;
+    double     io_timing_read;
+    seeding_t  init = SEEDING_FIRST;
+    char*      path = NULL; // binary dataset, if any
+    dataset_t* ds   = NULL;
+    double*    validation_clusters = NULL; // [numClusters * numCoords] for KMEANS_VALIDATE
+    double     validation_eps      = precision_validation_eps();
 
     /* some default values */
     _debug         = 0;
@@ -43,7 +56,7 @@ int main(int argc, char** argv) {
 
     LOG("\n~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n\n");
 
-    while ((opt = getopt(argc, argv, "n:t:l:c:s:dh")) != EOF) {
+    while ((opt = getopt(argc, argv, "n:t:l:c:s:f:i:dh")) != EOF) {
         switch (opt) {
             case 'c':
                 numClusters = atol(optarg);
@@ -60,6 +73,13 @@ int main(int argc, char** argv) {
             case 'n':
                 numCoords = atol(optarg);
                 break;
+            case 'f':
+                path = optarg;
+                break;
+            case 'i':
+                if (seeding_parse(optarg, &init))
+                    usage(argv[0]);
+                break;
             case 'd':
                 _debug = 1;
                 break;
@@ -73,7 +93,36 @@ int main(int argc, char** argv) {
         usage(argv[0]);
     }
 
-    numObjs = (dataset_size * 1024 * 1024) / (numCoords * sizeof(double));
+    /*
+     * Only the reduction engine has the float and soa variants, and validation compares one of them
+     * against the double aos path: anything else would run the same engine twice.
+     */
+    if (!kmeans_variants && (precision_get() != PRECISION_DOUBLE || layout_get() != LAYOUT_AOS ||
+                             validation_eps > 0.0)) {
+        printf("Error: this kmeans() implements neither KMEANS_PRECISION, KMEANS_LAYOUT nor "
+               "KMEANS_VALIDATE.\n");
+        return 1;
+    }
+    if (validation_eps > 0.0 && precision_get() == PRECISION_DOUBLE && layout_get() == LAYOUT_AOS) {
+        printf("Error: KMEANS_VALIDATE needs KMEANS_PRECISION=float|float-kahan or "
+               "KMEANS_LAYOUT=soa.\n");
+        return 1;
+    }
+
+    if (path) {
+        dataset_header_t hdr;
+
+        dataset_read_header(path, &hdr);
+        numObjs      = hdr.numObjs;
+        numCoords    = hdr.numCoords;
+        dataset_size = (double)numObjs * numCoords * sizeof(double) / (1024 * 1024);
+        if (numObjs * numCoords > 0x7fffffffL) {
+            printf("Error: %s is too large for the int indices of kmeans().\n", path);
+            return 1;
+        }
+    } else {
+        numObjs = (dataset_size * 1024 * 1024) / (numCoords * sizeof(double));
+    }
 
     if (numObjs < numClusters) {
         printf("Error: number of clusters must be larger than the number of data points to be "
@@ -87,18 +136,38 @@ int main(int argc, char** argv) {
         numClusters);
 
     io_timing_read = wtime();
-    objects        = dataset_generation(numObjs, numCoords);
+    if (path) {
+        ds      = dataset_open(path, 0, -1);
+        objects = ds->objects;
+    } else {
+        objects = dataset_generation(numObjs, numCoords);
+    }
     io_timing_read = wtime() - io_timing_read;
     // printf("I/O completed: %10.4f\n", io_timing_read);
+    // without KMEANS_PREFAULT the pages of a mapped file are only read by the first loop
+    if (path)
+        printf("dataset = %s, load = %7.4fs\n", path, io_timing_read);
+
+    if (placement_report()) {
+        long pages[placement_nodes() + 1];
+
+        memset(pages, 0, sizeof(pages));
+        placement_count(objects, numObjs * numCoords * sizeof(*objects), pages);
+        placement_print("objects", pages);
+    }
 
     // Allocate space for clusters (coordinates of cluster centers)
     clusters = (double*)malloc(numClusters * numCoords * sizeof(double));
 
-    // The first numClusters elements are selected as initial centers
-    for (i = 0; i < numClusters; i++)
-        for (j = 0; j < numCoords; j++) {
-            clusters[i * numCoords + j] = objects[i * numCoords + j];
-        }
+    // The initial centers are the first numClusters elements, or drawn with k-means++/k-means||
+    if (init == SEEDING_FIRST) {
+        seeding_init(init, objects, numObjs, numCoords, numClusters, clusters);
+    } else {
+        double seeding_timing = wtime();
+
+        seeding_init(init, objects, numObjs, numCoords, numClusters, clusters);
+        printf("seeding = %s, total = %7.4fs\n", seeding_name(init), wtime() - seeding_timing);
+    }
 
     // check initial cluster centers for repetition
     if (check_repeated_clusters(numClusters, numCoords, clusters) == 0) {
@@ -118,12 +187,41 @@ int main(int argc, char** argv) {
     // membership: the cluster id for each data object
     membership = (int*)malloc(numObjs * sizeof(int));
 
+    if (validation_eps > 0.0) {
+        validation_clusters = (double*)malloc(numClusters * numCoords * sizeof(double));
+        memcpy(validation_clusters, clusters, numClusters * numCoords * sizeof(double));
+    }
+
     // start the core computation
     LOG("\n");
     kmeans(
       objects, numCoords, numObjs, numClusters, threshold, loop_threshold, membership, clusters);
     LOG("\n");
 
+    // run again in double precision and aos layout from the same centers, and compare (see
+    // precision.h)
+    if (validation_eps > 0.0) {
+        double error;
+
+        precision_set(PRECISION_DOUBLE);
+        layout_set(LAYOUT_AOS);
+        kmeans(objects,
+               numCoords,
+               numObjs,
+               numClusters,
+               threshold,
+               loop_threshold,
+               membership,
+               validation_clusters);
+        error = precision_compare(validation_clusters, clusters, numClusters, numCoords);
+        printf("validation against double: max relative distance %.3g, %s\n",
+               error,
+               error < validation_eps ? "PASSED" : "FAILED");
+        free(validation_clusters);
+        if (error >= validation_eps)
+            return 1;
+    }
+
     LOG("Final cluster centers:\n");
     for (i = 0; i < numClusters; i++) {
         LOG("clusters[%ld]\t= ", i);
@@ -133,7 +231,10 @@ int main(int argc, char** argv) {
         LOG("\n");
     }
 
-    free(objects);
+    if (ds)
+        dataset_close(ds);
+    else
+        free(objects);
     free(membership);
     free(clusters);
 
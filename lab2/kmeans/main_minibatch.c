@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h> /* getopt() */
+
+int _debug;
+#include "dataset.h"
+#include "kmeans.h"
+#include "seeding.h"
+#include "stream.h"
+
+/*
+ * Driver of the mini-batch k-means. Unlike main.c it never generates the whole dataset: objects
+ * are streamed batch by batch, so -s (or the file of -f) may be far larger than the memory of the
+ * machine.
+ */
+
+static void usage(char* argv0) {
+    char* help = "Usage: %s [switches]\n"
+                 "       -c num_clusters    : number of clusters (must be > 1)\n"
+                 "       -s size            : size of examined dataset\n"
+                 "       -n num_coords      : number of coordinates\n"
+                 "       -f file            : stream a binary dataset (see dataset.h) instead of\n"
+                 "                            generating -s/-n random data\n"
+                 "       -b batch_size      : objects per mini-batch (default : 4096)\n"
+                 "       -t threshold       : threshold value (default : 0.001)\n"
+                 "       -l loop_threshold  : mini-batches threshold (default : 100)\n"
+                 "       -i init            : initial centers, first|kmeans++|kmeans|| (default : first)\n"
+                 "                            drawn from the first mini-batch\n"
+                 "       -d                 : enable debug mode\n"
+                 "       -h                 : print this help information\n";
+    fprintf(stderr, help, argv0);
+    exit(-1);
+}
+
+int main(int argc, char** argv) {
+    long         i, j, opt;
+    extern char* optarg;
+    extern int   optind;
+
+    long       numClusters = 0, numCoords = 0, numObjs = 0, batchSize;
+    double*    batch;    // [batchSize * numCoords] first mini-batch, for the seeding
+    double*    clusters; // [numClusters * numCoords] cluster center
+    double     dataset_size = 0, threshold;
+    long       loop_threshold;
+    seeding_t  init = SEEDING_FIRST;
+    stream_t*  src;
+    char*      path = NULL; // binary dataset, if any
+    dataset_t* ds   = NULL;
+
+    /* some default values */
+    _debug         = 0;
+    threshold      = 0.001;
+    loop_threshold = 100;
+    numClusters    = 0;
+    batchSize      = 4096;
+
+    LOG("\n~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n\n");
+
+    while ((opt = getopt(argc, argv, "n:t:l:c:s:f:b:i:dh")) != EOF) {
+        switch (opt) {
+            case 'c':
+                numClusters = atol(optarg);
+                break;
+            case 't':
+                threshold = atof(optarg);
+                break;
+            case 'l':
+                loop_threshold = atol(optarg);
+                break;
+            case 's':
+                dataset_size = atof(optarg);
+                break;
+            case 'n':
+                numCoords = atol(optarg);
+                break;
+            case 'f':
+                path = optarg;
+                break;
+            case 'b':
+                batchSize = atol(optarg);
+                break;
+            case 'i':
+                if (seeding_parse(optarg, &init))
+                    usage(argv[0]);
+                break;
+            case 'd':
+                _debug = 1;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+    if (numClusters <= 1 || (numCoords < 1 && !path)) {
+        usage(argv[0]);
+    }
+
+    if (path) {
+        ds           = dataset_map(path);
+        numObjs      = ds->numObjs;
+        numCoords    = ds->numCoords;
+        dataset_size = (double)numObjs * numCoords * sizeof(double) / (1024 * 1024);
+    } else {
+        numObjs = (dataset_size * 1024 * 1024) / (numCoords * sizeof(double));
+    }
+    if (batchSize > numObjs)
+        batchSize = numObjs;
+
+    if (batchSize < numClusters) {
+        printf("Error: the mini-batch must be larger than the number of clusters.\n");
+        return 1;
+    }
+    LOG("dataset_size = %.2f MB    numObjs = %ld    numCoords = %ld    numClusters = %ld    "
+        "batchSize = %ld\n",
+        dataset_size,
+        numObjs,
+        numCoords,
+        numClusters,
+        batchSize);
+
+    src = ds ? stream_open_dataset(ds) : stream_open(numObjs, numCoords);
+
+    // The initial centers come from the first mini-batch, which is then streamed again.
+    batch    = (double*)malloc(batchSize * numCoords * sizeof(double));
+    clusters = (double*)malloc(numClusters * numCoords * sizeof(double));
+    stream_next(src, batch, batchSize);
+    stream_rewind(src);
+    seeding_init(init, batch, batchSize, numCoords, numClusters, clusters);
+    free(batch);
+
+    // check initial cluster centers for repetition
+    if (check_repeated_clusters(numClusters, numCoords, clusters) == 0) {
+        LOG("Error: some initial clusters are repeated. Please select distinct initial centers\n");
+        return 1;
+    }
+
+    LOG("Initial cluster centers:\n");
+    for (i = 0; i < numClusters; i++) {
+        LOG("clusters[%ld]\t=", i);
+        for (j = 0; j < numCoords; j++) {
+            LOG(" %6.2f", clusters[i * numCoords + j]);
+        }
+        LOG("\n");
+    }
+
+    // start the core computation
+    LOG("\n");
+    kmeans_minibatch(src, numCoords, numClusters, batchSize, threshold, loop_threshold, clusters);
+    LOG("\n");
+
+    LOG("Final cluster centers:\n");
+    for (i = 0; i < numClusters; i++) {
+        LOG("clusters[%ld]\t= ", i);
+        for (j = 0; j < numCoords; j++) {
+            LOG("%6.2f ", clusters[i * numCoords + j]);
+        }
+        LOG("\n");
+    }
+
+    stream_close(src);
+    if (ds)
+        dataset_close(ds);
+    free(clusters);
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include "kmeans.h"
+#include "placement.h"
+#include "precision.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <omp.h>
+
+extern const char numa_aware[];
+
+/*
+ * Single-precision reduction k-means (see precision.h). The objects are converted to float once;
+ * every loop then reads half the bytes of the double path.
+ *
+ * The distances of an object to all centroids are computed together, vectorised across the
+ * centroids: the float centroids are kept transposed, [numCoords][kpad], so that for each
+ * coordinate one SIMD operation updates as many distances as the vector holds floats. This works
+ * for any numCoords, including the small ones that defeat vectorisation across coordinates.
+ * TILE objects share every load of the centroids.
+ *
+ * Kahan summation relies on the exact order of the float operations, so this file is compiled
+ * without -fassociative-math (see the Makefile).
+ */
+
+#define KPAD 16 // centroids are padded to a multiple of one AVX-512 vector of floats
+#define TILE 4  // objects whose distances are computed together, sharing the centroid loads
+
+// KPAD floats; lowered to whatever vectors the target_clones below have
+typedef float vfloat __attribute__((vector_size(KPAD * sizeof(float))));
+
+static void* xalign(size_t size) {
+    void* p;
+
+    if (posix_memalign(&p, 64, (size + 63) & ~(size_t)63)) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    memset(p, 0, (size + 63) & ~(size_t)63);
+    return p;
+}
+
+/*
+ * Nearest centroid of n objects. Compiled for AVX-512, AVX2 and baseline x86-64, the best one
+ * being picked at load time, since the build has no -march.
+ */
+__attribute__((target_clones("avx512f", "avx2", "default"))) static void
+nearest_block(const float* objects,   /* [n][numCoords] */
+              int          n,
+              int          numCoords,
+              const float* fclusters, /* [numCoords][kpad] */
+              int          kpad,
+              const float* penalty,   /* [kpad]: 0, and FLT_MAX / 2 for the padding centroids */
+              float*       dist,      /* scratch: [TILE][kpad], 64-byte aligned */
+              int*         nearest)   /* out: [n] */
+{
+    int i, t, j, k, kb, m;
+
+    for (i = 0; i < n; i += TILE) {
+        const float* x[TILE];
+
+        // a short last tile repeats its first object
+        m = (n - i < TILE) ? n - i : TILE;
+        for (t = 0; t < TILE; t++)
+            x[t] = &objects[(long)(i + (t < m ? t : 0)) * numCoords];
+
+        // KPAD centroids at a time: the distances of the tile to them, one coordinate at a time
+        for (kb = 0; kb < kpad; kb += KPAD) {
+            vfloat p = *(const vfloat*)&penalty[kb];
+            vfloat d[TILE];
+
+            for (t = 0; t < TILE; t++)
+                d[t] = p; // the padding centroids never win
+
+            for (j = 0; j < numCoords; j++) {
+                vfloat c = *(const vfloat*)&fclusters[j * kpad + kb];
+
+                #pragma GCC unroll 4
+                for (t = 0; t < TILE; t++)
+                    d[t] += (x[t][j] - c) * (x[t][j] - c);
+            }
+            for (t = 0; t < TILE; t++)
+                *(vfloat*)&dist[t * kpad + kb] = d[t];
+        }
+
+        // argmin without a branch per centroid: the minimum, folded in halves, then its first occurrence
+        for (t = 0; t < m; t++) {
+            float v[KPAD] __attribute__((aligned(64)));
+            int   w;
+
+            for (k = 0; k < KPAD; k++)
+                v[k] = dist[t * kpad + k];
+            for (kb = KPAD; kb < kpad; kb += KPAD)
+                for (k = 0; k < KPAD; k++)
+                    v[k] = (dist[t * kpad + kb + k] < v[k]) ? dist[t * kpad + kb + k] : v[k];
+            for (w = KPAD / 2; w > 0; w /= 2)
+                for (k = 0; k < w; k++)
+                    v[k] = (v[k + w] < v[k]) ? v[k + w] : v[k];
+
+            for (k = 0; dist[t * kpad + k] != v[0]; k++)
+                ;
+            nearest[i + t] = k;
+        }
+    }
+}
+
+void kmeans_float(double*     objects,        /* in: [numObjs][numCoords] */
+                  int         numCoords,      /* no. coordinates */
+                  int         numObjs,        /* no. objects */
+                  int         numClusters,    /* no. clusters */
+                  double      threshold,      /* minimum fraction of objects that change membership */
+                  long        loop_threshold, /* maximum number of iterations */
+                  int*        membership,     /* out: [numObjs] */
+                  double*     clusters,       /* out: [numClusters][numCoords] */
+                  precision_t p)              /* PRECISION_FLOAT or PRECISION_FLOAT_KAHAN */
+{
+    int    i, j, k;
+    int    loop = 0;
+    double timing = 0, convert;
+
+    double delta;        // fraction of objects whose clusters change in each loop
+    int    nthreads;     // no. threads
+    int    b;            // first object of the current block
+    int    kpad = (numClusters + KPAD - 1) / KPAD * KPAD;
+    int    kahan = (p == PRECISION_FLOAT_KAHAN);
+    float* fobjects;     // [numObjs][numCoords]
+    float* fclusters;    // [numCoords][kpad]: transposed centroids
+    float* penalty;      // [kpad]: added to the distances to the padding centroids
+
+    nthreads = omp_get_max_threads();
+    LOG("OpenMP Kmeans - Reduction, %s\t(number of threads: %d)\n", precision_name(p), nthreads);
+
+    // the float copy, first touched with the schedule of the compute loop
+    convert  = wtime();
+    fobjects = (typeof(fobjects))placement_alloc((size_t)numObjs * numCoords * sizeof(*fobjects));
+    // clang-format off
+    #pragma omp parallel for private(i) schedule(static)
+    // clang-format on
+    for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+        for (i = b * numCoords; i < ((b + OBJ_BLOCK < numObjs) ? b + OBJ_BLOCK : numObjs) * numCoords; i++)
+            fobjects[i] = objects[i];
+    }
+    convert = wtime() - convert;
+
+    fclusters = (typeof(fclusters))xalign((size_t)numCoords * kpad * sizeof(*fclusters));
+    penalty   = (typeof(penalty))xalign(kpad * sizeof(*penalty));
+    for (k = numClusters; k < kpad; k++)
+        penalty[k] = FLT_MAX / 2;
+
+    for (i = 0; i < numObjs; i++)
+        membership[i] = -1;
+
+    /*
+     * Per-thread accumulators: sums in double, or in float with a Kahan compensation term
+     * (float-kahan), which keeps most of the low-order bits a plain float sum would lose.
+     */
+    int*    local_newClusterSize[nthreads]; // [nthreads][numClusters]
+    double* local_newClusters[nthreads];    // [nthreads][numClusters][numCoords] (float)
+    float*  local_floatClusters[nthreads];  // [nthreads][numClusters][numCoords] (float-kahan)
+    float*  local_compensation[nthreads];   // [nthreads][numClusters][numCoords] (float-kahan)
+    float*  local_dist[nthreads];           // [nthreads][TILE][kpad]: scratch of nearest_block()
+
+    // clang-format off
+    #pragma omp parallel for schedule(static)
+    // clang-format on
+    for (k = 0; k < nthreads; k++) {
+        local_newClusterSize[k] = (typeof(local_newClusterSize[k]))xalign(numClusters * sizeof(int));
+        local_dist[k]           = (typeof(local_dist[k]))xalign((size_t)TILE * kpad * sizeof(float));
+        local_newClusters[k]    = NULL;
+        local_floatClusters[k]  = NULL;
+        local_compensation[k]   = NULL;
+        if (kahan) {
+            local_floatClusters[k] = (typeof(local_floatClusters[k]))xalign(numClusters * numCoords * sizeof(float));
+            local_compensation[k]  = (typeof(local_compensation[k]))xalign(numClusters * numCoords * sizeof(float));
+        } else {
+            local_newClusters[k] = (typeof(local_newClusters[k]))xalign(numClusters * numCoords * sizeof(double));
+        }
+    }
+
+    timing = wtime();
+    do {
+        delta = 0.0;
+
+        for (i = 0; i < numClusters; i++)
+            for (j = 0; j < numCoords; j++)
+                fclusters[j * kpad + i] = clusters[i * numCoords + j];
+
+        // clang-format off
+        #pragma omp parallel shared(fobjects, fclusters, penalty, clusters, membership, local_newClusterSize, local_newClusters, local_floatClusters, local_compensation, local_dist)
+        {
+            int tid = omp_get_thread_num();
+            int nearest[OBJ_BLOCK];
+            int n;
+
+            #pragma omp for private(i, j, n) schedule(static) reduction(+ : delta)
+            for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+                n = (numObjs - b < OBJ_BLOCK) ? numObjs - b : OBJ_BLOCK;
+                nearest_block(&fobjects[(long)b * numCoords], n, numCoords, fclusters, kpad, penalty,
+                              local_dist[tid], nearest);
+
+                for (i = b; i < b + n; i++) {
+                    const float* object = &fobjects[(long)i * numCoords];
+                    int          index  = nearest[i - b];
+
+                    if (membership[i] != index)
+                        delta += 1.0;
+                    membership[i] = index;
+
+                    local_newClusterSize[tid][index]++;
+                    if (kahan) {
+                        float* sum  = &local_floatClusters[tid][index * numCoords];
+                        float* comp = &local_compensation[tid][index * numCoords];
+
+                        for (j = 0; j < numCoords; j++) {
+                            float y = object[j] - comp[j];
+                            float t = sum[j] + y;
+
+                            comp[j] = (t - sum[j]) - y;
+                            sum[j]  = t;
+                        }
+                    } else {
+                        for (j = 0; j < numCoords; j++)
+                            local_newClusters[tid][index * numCoords + j] += object[j];
+                    }
+                }
+            }
+
+            // Reduction in double, each thread owning whole clusters, as in the double path.
+            #pragma omp for private(i, j, k) schedule(static)
+            for (i = 0; i < numClusters; i++) {
+                int size = 0;
+
+                for (j = 0; j < nthreads; j++)
+                    size += local_newClusterSize[j][i];
+                if (size == 0)
+                    continue;
+
+                for (k = 0; k < numCoords; k++) {
+                    double sum = 0.0;
+
+                    for (j = 0; j < nthreads; j++) {
+                        if (kahan)
+                            sum += (double)local_floatClusters[j][i * numCoords + k] - local_compensation[j][i * numCoords + k];
+                        else
+                            sum += local_newClusters[j][i * numCoords + k];
+                    }
+                    clusters[i * numCoords + k] = sum / size;
+                }
+            }
+
+            // everybody is done reading the local arrays: each thread zeroes its own
+            memset(local_newClusterSize[tid], 0, numClusters * sizeof(int));
+            if (kahan) {
+                memset(local_floatClusters[tid], 0, numClusters * numCoords * sizeof(float));
+                memset(local_compensation[tid], 0, numClusters * numCoords * sizeof(float));
+            } else {
+                memset(local_newClusters[tid], 0, numClusters * numCoords * sizeof(double));
+            }
+        } // end of #pragma omp parallel
+        // clang-format on
+
+        delta /= numObjs;
+
+        loop++;
+        LOG("\r\tcompleted loop %d", loop);
+        LOG_FLUSH();
+
+    } while (delta > threshold && loop < loop_threshold);
+
+    timing = wtime() - timing;
+    printf("nthreads = %2d, nloops = %3d, total = %7.4fs, per loop = %7.4fs, numa = %s, precision = %s, "
+           "conversion = %7.4fs\n",
+           nthreads,
+           loop,
+           timing,
+           timing / loop,
+           numa_aware,
+           precision_name(p),
+           convert);
+
+    for (k = 0; k < nthreads; k++) {
+        free(local_newClusterSize[k]);
+        free(local_newClusters[k]);
+        free(local_floatClusters[k]);
+        free(local_compensation[k]);
+        free(local_dist[k]);
+    }
+    free(fclusters);
+    free(penalty);
+    free(fobjects);
+}
@@ -0,0 +1,209 @@
+#include "distance.h"
+#include "kmeans.h"
+#include "stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <omp.h>
+
+/*
+ * Mini-batch k-means (D. Sculley, "Web-Scale K-Means Clustering"). Every loop draws a batch of
+ * batchSize objects sampled over the whole stream (see stream.h), assigns them to their nearest
+ * center and moves each center towards the mean of its batch members with a per-center learning
+ * rate of (members in this batch) / (members over all batches so far). That is the running mean of every
+ * object the center was given, so the steps shrink as a center accumulates history.
+ *
+ * Memory is bounded by the batch, the centers and the per-thread accumulators, whatever the size of
+ * the dataset. There is no membership: the stream is not kept.
+ */
+
+// square of Euclid distance between two multi-dimensional points
+inline static double euclid_dist_2(int     numdims, /* no. dimensions */
+                                   double* coord1,  /* [numdims] */
+                                   double* coord2)  /* [numdims] */
+{
+    int    i;
+    double ans = 0.0;
+
+    for (i = 0; i < numdims; i++)
+        ans += (coord1[i] - coord2[i]) * (coord1[i] - coord2[i]);
+
+    return ans;
+}
+
+inline static int find_nearest_cluster(int     numClusters, /* no. clusters */
+                                       int     numCoords,   /* no. coordinates */
+                                       double* object,      /* [numCoords] */
+                                       double* clusters)    /* [numClusters][numCoords] */
+{
+    int    index, i;
+    double dist, min_dist;
+
+    // find the cluster id that has min distance to object
+    index    = 0;
+    min_dist = euclid_dist_2(numCoords, object, clusters);
+
+    for (i = 1; i < numClusters; i++) {
+        dist = euclid_dist_2(numCoords, object, &clusters[i * numCoords]);
+        // no need square root
+        if (dist < min_dist) { // find the min and its array index
+            min_dist = dist;
+            index    = i;
+        }
+    }
+    return index;
+}
+
+void kmeans_minibatch(struct stream* src,            /* in: objects, batchSize at a time */
+                      int            numCoords,      /* no. coordinates */
+                      int            numClusters,    /* no. clusters */
+                      int            batchSize,      /* no. objects per loop */
+                      double         threshold,      /* minimum relative movement of the centers */
+                      long           loop_threshold, /* maximum number of batches */
+                      double*        clusters)       /* in/out: [numClusters][numCoords] */
+{
+    int    i, j, k;
+    int    index, loop = 0;
+    double timing = 0;
+
+    double  delta;          // relative movement of the centers in each loop
+    double  shift, norm;    // squared movement and squared norm of the new centers
+    long*   seen;           // [numClusters]: no. objects assigned to each center over all batches
+    double* batch;          // [batchSize][numCoords]
+    int     nthreads;       // no. threads
+    int     b;              // first object of the current block
+    dist_centroids_t* dist; // packed centroids for the blocked distance engine
+
+    nthreads = omp_get_max_threads();
+    LOG("OpenMP Kmeans - Mini-batch\t(number of threads: %d)\n", nthreads);
+
+    // KMEANS_DIST=scalar keeps the original one-distance-at-a-time search
+    dist = dist_use_scalar() ? NULL : dist_init(numClusters, numCoords);
+
+    seen  = (typeof(seen))calloc(numClusters, sizeof(*seen));
+    batch = (typeof(batch))malloc((size_t)batchSize * numCoords * sizeof(*batch));
+    if (!seen || !batch) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+
+    // per-thread sums of the batch members of every center, as in the reduction version
+    int*    local_newClusterSize[nthreads]; // [nthreads][numClusters]
+    double* local_newClusters[nthreads];    // [nthreads][numClusters][numCoords]
+
+    // clang-format off
+    #pragma omp parallel for schedule(static)
+    // clang-format on
+    for (k = 0; k < nthreads; k++) {
+        size_t sizeBytes = (numClusters * sizeof(**local_newClusterSize) + 63) & ~(size_t)63;
+        size_t dataBytes = (numClusters * numCoords * sizeof(**local_newClusters) + 63) & ~(size_t)63;
+
+        if (posix_memalign((void**)&local_newClusterSize[k], 64, sizeBytes) ||
+            posix_memalign((void**)&local_newClusters[k], 64, dataBytes)) {
+            fprintf(stderr, "Out of memory.\n");
+            exit(1);
+        }
+        memset(local_newClusterSize[k], 0, sizeBytes);
+        memset(local_newClusters[k], 0, dataBytes);
+    }
+
+    timing = wtime();
+    do {
+        shift = 0.0;
+        norm  = 0.0;
+
+        stream_next(src, batch, batchSize);
+        if (dist)
+            dist_pack(dist, clusters);
+
+        // clang-format off
+        #pragma omp parallel shared(batch, clusters, seen, local_newClusters, local_newClusterSize, dist)
+        {
+            int tid = omp_get_thread_num();
+            int nearest[OBJ_BLOCK];
+            int n;
+
+            #pragma omp for private(i, j, index, n) schedule(static)
+            for (b = 0; b < batchSize; b += OBJ_BLOCK) {
+                n = (batchSize - b < OBJ_BLOCK) ? batchSize - b : OBJ_BLOCK;
+
+                // find the array index of nearest cluster center for the whole block
+                if (dist)
+                    dist_argmin(dist, &batch[(long)b * numCoords], n, nearest, NULL);
+                else
+                    for (i = 0; i < n; i++)
+                        nearest[i] = find_nearest_cluster(numClusters, numCoords, &batch[(long)(b + i) * numCoords], clusters);
+
+                for (i = b; i < b + n; i++) {
+                    index = nearest[i - b];
+
+                    local_newClusterSize[tid][index]++;
+                    for (j = 0; j < numCoords; j++)
+                        local_newClusters[tid][index * numCoords + j] += batch[(long)i * numCoords + j];
+                }
+            }
+
+            /*
+             * Each thread owns whole clusters: it reduces their per-thread sums and takes the
+             * gradient step c += (sum - n c) / seen, i.e. towards the batch mean with rate n / seen.
+             */
+            #pragma omp for private(i, j, k) schedule(static) reduction(+ : shift, norm)
+            for (i = 0; i < numClusters; i++) {
+                double sum, step;
+                int    members = 0;
+
+                for (j = 0; j < nthreads; j++)
+                    members += local_newClusterSize[j][i];
+                if (members == 0) {
+                    for (k = 0; k < numCoords; k++)
+                        norm += clusters[i * numCoords + k] * clusters[i * numCoords + k];
+                    continue;
+                }
+                seen[i] += members;
+
+                for (k = 0; k < numCoords; k++) {
+                    for (sum = 0.0, j = 0; j < nthreads; j++)
+                        sum += local_newClusters[j][i * numCoords + k];
+                    step = (sum - members * clusters[i * numCoords + k]) / seen[i];
+                    clusters[i * numCoords + k] += step;
+                    shift += step * step;
+                    norm  += clusters[i * numCoords + k] * clusters[i * numCoords + k];
+                }
+            }
+
+            // everybody is done reading the local arrays: each thread zeroes its own
+            memset(local_newClusterSize[tid], 0, numClusters * sizeof(**local_newClusterSize));
+            memset(local_newClusters[tid], 0, numClusters * numCoords * sizeof(**local_newClusters));
+        } // end of #pragma omp parallel
+        // clang-format on
+
+        // There is no membership to count changes of: converge on the movement of the centers
+        // relative to their size instead.
+        delta = norm > 0.0 ? sqrt(shift / norm) : 0.0;
+
+        loop++;
+        LOG("\r\tcompleted loop %d", loop);
+        LOG_FLUSH();
+
+    } while (delta > threshold && loop < loop_threshold);
+
+    timing = wtime() - timing;
+    printf("nthreads = %2d, nloops = %3d, total = %7.4fs, per loop = %7.4fs, batch = %d, dist = %s\n",
+           nthreads,
+           loop,
+           timing,
+           timing / loop,
+           batchSize,
+           dist ? dist->name : "scalar");
+
+    for (k = 0; k < nthreads; k++) {
+        free(local_newClusterSize[k]);
+        free(local_newClusters[k]);
+    }
+    free(seen);
+    free(batch);
+    if (dist)
+        dist_free(dist);
+}
@@ -6,6 +6,9 @@
 // TODO: include openmp header file
 #include <omp.h>
 
+// double precision and aos only: KMEANS_PRECISION, KMEANS_LAYOUT and KMEANS_VALIDATE are refused
+const int kmeans_variants = 0;
+
 // square of Euclid distance between two multi-dimensional points
 inline static double euclid_dist_2(int     numdims, /* no. dimensions */
                                    double* coord1,  /* [numdims] */
@@ -44,6 +47,75 @@ inline static int find_nearest_cluster(int     numClusters, /* no. clusters */
     return index;
 }
 
+/*
+ * One parallel assignment pass, with the atomic updates of the shared sums; returns the number of
+ * membership changes. It is generated for a few numCoords known at compile time, as in
+ * seq_kmeans.c, so that the distance and accumulation loops unroll.
+ */
+// clang-format off
+#define KMEANS_ASSIGN(NAME, DIMS)                                                                  \
+    static double NAME(double* objects,                                                            \
+                       int     numCoords,                                                          \
+                       int     numObjs,                                                            \
+                       int     numClusters,                                                        \
+                       double* clusters,                                                           \
+                       int*    membership,                                                         \
+                       int*    newClusterSize,                                                     \
+                       double* newClusters)                                                        \
+    {                                                                                              \
+        double delta = 0.0;                                                                        \
+        int    i, j, index;                                                                        \
+                                                                                                   \
+        (void)numCoords;                                                                           \
+        _Pragma("omp parallel for private(i, j, index) schedule(static) reduction(+ : delta)")     \
+        for (i = 0; i < numObjs; i++) {                                                            \
+            index = find_nearest_cluster(numClusters, (DIMS), &objects[i * (DIMS)], clusters);     \
+                                                                                                   \
+            if (membership[i] != index)                                                            \
+                delta += 1.0;                                                                      \
+            membership[i] = index;                                                                 \
+                                                                                                   \
+            _Pragma("omp atomic")                                                                  \
+            newClusterSize[index]++;                                                               \
+            for (j = 0; j < (DIMS); j++) {                                                         \
+                _Pragma("omp atomic")                                                              \
+                newClusters[index * (DIMS) + j] += objects[i * (DIMS) + j];                        \
+            }                                                                                      \
+        }                                                                                          \
+        return delta;                                                                              \
+    }
+// clang-format on
+
+KMEANS_ASSIGN(assign_generic, numCoords)
+KMEANS_ASSIGN(assign_2, 2)
+KMEANS_ASSIGN(assign_4, 4)
+KMEANS_ASSIGN(assign_8, 8)
+KMEANS_ASSIGN(assign_16, 16)
+KMEANS_ASSIGN(assign_32, 32)
+KMEANS_ASSIGN(assign_64, 64)
+
+typedef double (*assign_fn)(double*, int, int, int, double*, int*, int*, double*);
+
+// pick the specialised pass for numCoords, once per run; other sizes use the generic one
+static assign_fn select_assign(int numCoords) {
+    switch (numCoords) {
+        case 2:
+            return assign_2;
+        case 4:
+            return assign_4;
+        case 8:
+            return assign_8;
+        case 16:
+            return assign_16;
+        case 32:
+            return assign_32;
+        case 64:
+            return assign_64;
+        default:
+            return assign_generic;
+    }
+}
+
 void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             int     numCoords,      /* no. coordinates */
             int     numObjs,        /* no. objects */
@@ -54,13 +126,14 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             double* clusters)       /* out: [numClusters][numCoords] */
 {
     int    i, j;
-    int    index, loop = 0;
+    int    loop = 0;
     double timing = 0;
 
-    double  delta;          // fraction of objects whose clusters change in each loop
-    int*    newClusterSize; // [numClusters]: no. objects assigned in each new cluster
-    double* newClusters;    // [numClusters][numCoords]
-    int     nthreads;       // no. threads
+    double    delta;          // fraction of objects whose clusters change in each loop
+    int*      newClusterSize; // [numClusters]: no. objects assigned in each new cluster
+    double*   newClusters;    // [numClusters][numCoords]
+    int       nthreads;       // no. threads
+    assign_fn assign = select_assign(numCoords);
 
     nthreads = omp_get_max_threads();
     LOG("OpenMP Kmeans - Naive\t(number of threads: %d)\n", nthreads);
@@ -85,41 +158,14 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             newClusterSize[i] = 0;
         }
 
-        delta = 0.0;
-
-        // clang-format off
-        // TODO: Detect parallelizable region and use appropriate OpenMP pragmas
-        #pragma omp parallel for private(i, j, index)                               \
-            firstprivate(numObjs, numClusters, numCoords)                       \
-            shared(objects, clusters, membership, newClusters, newClusterSize)  \
-            schedule(static)                                                    \
-            reduction(+ : delta)
-
-        for (i = 0; i < numObjs; i++) {
-            // find the array index of nearest cluster center
-            index = find_nearest_cluster(numClusters, numCoords, &objects[i * numCoords], clusters);
-
-            // if membership changes, increase delta by 1
-            if (membership[i] != index) {
-                delta += 1.0;
-            }
-
-            // assign the membership to object i
-            membership[i] = index;
-
-            // update new cluster centers : sum of objects located within
-            // TODO: protect update on shared "newClusterSize" array
-            #pragma omp atomic
-            newClusterSize[index]++;
-
-            for (j = 0; j < numCoords; j++) {
-                // TODO: protect update on shared "newClusters" array
-                #pragma omp atomic
-                newClusters[index * numCoords + j] += objects[i * numCoords + j];
-            }
-
-            // clang-format on
-        }
+        delta = assign(objects,
+                       numCoords,
+                       numObjs,
+                       numClusters,
+                       clusters,
+                       membership,
+                       newClusterSize,
+                       newClusters);
 
         // average the sum and replace old cluster centers with newClusters
         for (i = 0; i < numClusters; i++) {
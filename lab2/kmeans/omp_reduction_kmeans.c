@@ -1,11 +1,21 @@
+#include "bounds.h"
+#include "distance.h"
 #include "kmeans.h"
+#include "layout.h"
+#include "placement.h"
+#include "precision.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // TODO: include openmp header file
 #include <omp.h>
 
 extern const char numa_aware[];
+
+// the float (omp_float_kmeans.c) and soa (omp_soa_kmeans.c) paths, checked with KMEANS_VALIDATE
+const int kmeans_variants = 1;
+
 // square of Euclid distance between two multi-dimensional points
 inline static double euclid_dist_2(int     numdims, /* no. dimensions */
                                    double* coord1,  /* [numdims] */
@@ -43,6 +53,111 @@ inline static int find_nearest_cluster(int     numClusters, /* no. clusters */
     return index;
 }
 
+/*
+ * How many pages of the objects and of the accumulators live on the node of the thread that uses
+ * them, following the schedule of the compute loop.
+ */
+static void report_locality(double*  objects,
+                            int      numObjs,
+                            int      numCoords,
+                            int      numClusters,
+                            int      nthreads,
+                            double** local_newClusters)
+{
+    long objLocal = 0, objTotal = 0, accLocal = 0, accTotal = 0;
+    int  b;
+
+    // clang-format off
+    #pragma omp parallel num_threads(nthreads) reduction(+ : objLocal, objTotal, accLocal, accTotal)
+    // clang-format on
+    {
+        int  tid  = omp_get_thread_num();
+        int  node = placement_current_node();
+        long mine[placement_nodes() + 1];
+        long first = -1, last = -1;
+        int  n;
+
+        // clang-format off
+        #pragma omp for schedule(static) nowait
+        // clang-format on
+        for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+            if (first < 0)
+                first = b;
+            last = (b + OBJ_BLOCK < numObjs) ? b + OBJ_BLOCK : numObjs;
+        }
+
+        memset(mine, 0, sizeof(mine));
+        if (first >= 0)
+            placement_count(&objects[first * numCoords], (last - first) * numCoords * sizeof(*objects), mine);
+        for (n = 0; n <= placement_nodes(); n++)
+            objTotal += mine[n];
+        if (node >= 0)
+            objLocal += mine[node];
+
+        memset(mine, 0, sizeof(mine));
+        placement_count(local_newClusters[tid], numClusters * numCoords * sizeof(**local_newClusters), mine);
+        for (n = 0; n <= placement_nodes(); n++)
+            accTotal += mine[n];
+        if (node >= 0)
+            accLocal += mine[node];
+    }
+
+    printf("placement local to their thread: objects %.1f%%, accumulators %.1f%%\n",
+           objTotal ? 100.0 * objLocal / objTotal : 0.0,
+           accTotal ? 100.0 * accLocal / accTotal : 0.0);
+}
+
+/*
+ * Nearest centers of the n objects of a block, for KMEANS_DIST=scalar. It is generated for a few
+ * numCoords known at compile time, as the assignment pass of seq_kmeans.c, so that euclid_dist_2
+ * unrolls; the dispatch is once per block.
+ */
+#define KMEANS_NEAREST(NAME, DIMS)                                                                 \
+    static void NAME(int     numClusters,                                                          \
+                     int     numCoords,                                                            \
+                     double* objects,                                                              \
+                     int     n,                                                                    \
+                     double* clusters,                                                             \
+                     int*    nearest)                                                              \
+    {                                                                                              \
+        int i;                                                                                     \
+                                                                                                   \
+        (void)numCoords;                                                                           \
+        for (i = 0; i < n; i++)                                                                    \
+            nearest[i] =                                                                           \
+              find_nearest_cluster(numClusters, (DIMS), &objects[i * (DIMS)], clusters);           \
+    }
+
+KMEANS_NEAREST(nearest_generic, numCoords)
+KMEANS_NEAREST(nearest_2, 2)
+KMEANS_NEAREST(nearest_4, 4)
+KMEANS_NEAREST(nearest_8, 8)
+KMEANS_NEAREST(nearest_16, 16)
+KMEANS_NEAREST(nearest_32, 32)
+KMEANS_NEAREST(nearest_64, 64)
+
+typedef void (*nearest_fn)(int, int, double*, int, double*, int*);
+
+// pick the specialised search for numCoords, once per run; other sizes use the generic one
+static nearest_fn select_nearest(int numCoords) {
+    switch (numCoords) {
+        case 2:
+            return nearest_2;
+        case 4:
+            return nearest_4;
+        case 8:
+            return nearest_8;
+        case 16:
+            return nearest_16;
+        case 32:
+            return nearest_32;
+        case 64:
+            return nearest_64;
+        default:
+            return nearest_generic;
+    }
+}
+
 void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             int     numCoords,      /* no. coordinates */
             int     numObjs,        /* no. objects */
@@ -60,10 +175,56 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
     int*    newClusterSize; // [numClusters]: no. objects assigned in each new cluster
     double* newClusters;    // [numClusters][numCoords]
     int     nthreads;       // no. threads
+    int     b;              // first object of the current block
+    dist_centroids_t* dist; // packed centroids for the blocked distance engine
+    bounds_t*         bnd;  // triangle-inequality bounds, if KMEANS_BOUNDS asks for them
+    nearest_fn        scan; // search of KMEANS_DIST=scalar, specialised for numCoords
+    long long         ndist;
+
+    /*
+     * The float and soa engines are separate paths without bounds, and there is no float soa:
+     * refuse a combination rather than time another engine than the one asked for.
+     */
+    if (precision_get() != PRECISION_DOUBLE &&
+        (layout_get() != LAYOUT_AOS || bounds_mode() != BOUNDS_NONE)) {
+        fprintf(stderr,
+                "KMEANS_PRECISION=%s cannot be combined with KMEANS_LAYOUT=soa or KMEANS_BOUNDS.\n",
+                precision_name(precision_get()));
+        exit(1);
+    }
+    if (layout_get() == LAYOUT_SOA && bounds_mode() != BOUNDS_NONE) {
+        fprintf(stderr, "KMEANS_LAYOUT=soa cannot be combined with KMEANS_BOUNDS.\n");
+        exit(1);
+    }
+
+    // KMEANS_PRECISION=float|float-kahan takes the single-precision path (see precision.h)
+    if (precision_get() != PRECISION_DOUBLE) {
+        kmeans_float(objects,
+                     numCoords,
+                     numObjs,
+                     numClusters,
+                     threshold,
+                     loop_threshold,
+                     membership,
+                     clusters,
+                     precision_get());
+        return;
+    }
+    // KMEANS_LAYOUT=soa transposes the objects and vectorises across them (see layout.h)
+    if (layout_get() == LAYOUT_SOA) {
+        kmeans_soa(
+          objects, numCoords, numObjs, numClusters, threshold, loop_threshold, membership, clusters);
+        return;
+    }
 
     nthreads = omp_get_max_threads();
     LOG("OpenMP Kmeans - Reduction\t(number of threads: %d)\n", nthreads);
 
+    // KMEANS_DIST=scalar keeps the original one-distance-at-a-time search
+    dist = dist_use_scalar() ? NULL : dist_init(numClusters, numCoords);
+    scan = select_nearest(numCoords);
+    bnd  = bounds_init(numObjs, numClusters, numCoords);
+
     // initialize membership
     for (i = 0; i < numObjs; i++)
         membership[i] = -1;
@@ -72,87 +233,114 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
     newClusterSize = (typeof(newClusterSize))calloc(numClusters, sizeof(*newClusterSize));
     newClusters    = (typeof(newClusters))calloc(numClusters * numCoords, sizeof(*newClusters));
 
-    // Each thread calculates new centers using a private space. After that, thread 0 does an array
-    // reduction on them.
+    // Each thread calculates new centers using a private space. After that, all threads reduce
+    // them, each one a share of the clusters.
     int*    local_newClusterSize[nthreads]; // [nthreads][numClusters]
     double* local_newClusters[nthreads];    // [nthreads][numClusters][numCoords]
 
     /*
-     * Hint for false-sharing
-     * This is noticed when numCoords is low (and neighboring local_newClusters exist close to each
-     * other). Allocate local cluster data with a "first-touch" policy.
+     * Each thread allocates and zeroes its own buffers, so that they are first touched on its
+     * node. They are cache-line aligned and padded so that neighbouring buffers never share a line
+     * (false sharing hurts the most when numCoords is low).
      */
-    // Initialize local (per-thread) arrays (and later collect result on global arrays)
-    // #pragma omp parallel for schedule(static)
+    // clang-format off
+    #pragma omp parallel for schedule(static)
+    // clang-format on
     for (k = 0; k < nthreads; k++) {
-        local_newClusterSize[k] =
-          (typeof(*local_newClusterSize))calloc(numClusters, sizeof(**local_newClusterSize));
-        local_newClusters[k] =
-          (typeof(*local_newClusters))calloc(numClusters * numCoords, sizeof(**local_newClusters));
+        size_t sizeBytes = (numClusters * sizeof(**local_newClusterSize) + 63) & ~(size_t)63;
+        size_t dataBytes = (numClusters * numCoords * sizeof(**local_newClusters) + 63) & ~(size_t)63;
+
+        if (posix_memalign((void**)&local_newClusterSize[k], 64, sizeBytes) ||
+            posix_memalign((void**)&local_newClusters[k], 64, dataBytes)) {
+            fprintf(stderr, "Out of memory.\n");
+            exit(1);
+        }
+        memset(local_newClusterSize[k], 0, sizeBytes);
+        memset(local_newClusters[k], 0, dataBytes);
     }
 
+    if (placement_report())
+        report_locality(objects, numObjs, numCoords, numClusters, nthreads, local_newClusters);
+
     timing = wtime();
     do {
-        // before each loop, set cluster data to 0
-        for (i = 0; i < numClusters; i++) {
-            for (j = 0; j < numCoords; j++)
-                newClusters[i * numCoords + j] = 0.0;
-            newClusterSize[i] = 0;
-        }
-
         delta = 0.0;
+        ndist = 0;
 
-        // TODO: Initialize local cluster data to zero (separate for each thread)
-        // We will do this when we get the results from each thread
+        if (bnd)
+            bounds_prepare(bnd, clusters);
+        else if (dist)
+            dist_pack(dist, clusters);
 
         // clang-format off
-        #pragma omp parallel shared(objects, clusters, membership, local_newClusters, local_newClusterSize)
+        #pragma omp parallel shared(objects, clusters, membership, local_newClusters, local_newClusterSize, dist, bnd)
         {
             int tid = omp_get_thread_num();
+            int nearest[OBJ_BLOCK];
+            int n;
 
-            #pragma omp for private(i, j, index) firstprivate(numObjs, numClusters, numCoords) schedule(static) reduction(+ : delta)
-            for (i = 0; i < numObjs; i++) {
-                // find the array index of nearest cluster center
-                index = find_nearest_cluster(numClusters, numCoords, &objects[i * numCoords], clusters);
+            #pragma omp for private(i, j, index, n) firstprivate(numObjs, numClusters, numCoords) schedule(static) reduction(+ : delta, ndist)
+            for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+                n = (numObjs - b < OBJ_BLOCK) ? numObjs - b : OBJ_BLOCK;
 
-                // if membership changes, increase delta by 1
-                if (membership[i] != index)
-                    delta += 1.0;
+                // find the array index of nearest cluster center for the whole block
+                if (bnd)
+                    for (i = 0; i < n; i++)
+                        nearest[i] = bounds_assign(bnd, &objects[(b + i) * numCoords], b + i, membership[b + i], clusters, &ndist);
+                else if (dist)
+                    dist_argmin(dist, &objects[b * numCoords], n, nearest, NULL);
+                else
+                    scan(numClusters, numCoords, &objects[b * numCoords], n, clusters, nearest);
 
-                // assign the membership to object i
-                membership[i] = index;
+                for (i = b; i < b + n; i++) {
+                    index = nearest[i - b];
 
-                // update new cluster centers : sum of all objects located within (average will be performed later)
-                // TODO: Collect cluster data in local arrays (local to each thread) Replace global arrays with local per-thread
-                local_newClusterSize[tid][index]++;
-                for (j = 0; j < numCoords; j++)
-                    local_newClusters[tid][index * numCoords + j] += objects[i * numCoords + j];
-            }
-        } // end of #pragma omp parallel
-        // clang-format on
+                    // if membership changes, increase delta by 1
+                    if (membership[i] != index)
+                        delta += 1.0;
+
+                    // assign the membership to object i
+                    membership[i] = index;
 
-        // TODO: Reduction of cluster data from local arrays to shared. This operation will be
-        // performed by one thread
-        for (i = 0; i < numClusters; i++) {
-            for (j = 0; j < nthreads; j++) {
-                newClusterSize[i] += local_newClusterSize[j][i];
-                local_newClusterSize[j][i] = 0.0;
-                for (k = 0; k < numCoords; k++) {
-                    newClusters[i * numCoords + k] += local_newClusters[j][i * numCoords + k];
-                    local_newClusters[j][i * numCoords + k] = 0.0;
+                    // update new cluster centers : sum of all objects located within (average will be performed later)
+                    // TODO: Collect cluster data in local arrays (local to each thread) Replace global arrays with local per-thread
+                    local_newClusterSize[tid][index]++;
+                    for (j = 0; j < numCoords; j++)
+                        local_newClusters[tid][index * numCoords + j] += objects[i * numCoords + j];
                 }
             }
-        }
 
-        // average the sum and replace old cluster centers with newClusters
-        for (i = 0; i < numClusters; i++) {
-            if (newClusterSize[i] > 0) {
-                for (j = 0; j < numCoords; j++) {
-                    clusters[i * numCoords + j] =
-                      newClusters[i * numCoords + j] / newClusterSize[i];
+            /*
+             * Reduction of the per-thread cluster data, with the clusters partitioned across the
+             * threads. Each thread owns whole clusters, so it can also average them and replace
+             * the old centers right away.
+             */
+            #pragma omp for private(i, j, k) schedule(static)
+            for (i = 0; i < numClusters; i++) {
+                newClusterSize[i] = 0;
+                for (k = 0; k < numCoords; k++)
+                    newClusters[i * numCoords + k] = 0.0;
+                for (j = 0; j < nthreads; j++) {
+                    newClusterSize[i] += local_newClusterSize[j][i];
+                    for (k = 0; k < numCoords; k++)
+                        newClusters[i * numCoords + k] += local_newClusters[j][i * numCoords + k];
+                }
+
+                // average the sum and replace old cluster centers with newClusters
+                if (newClusterSize[i] > 0) {
+                    for (k = 0; k < numCoords; k++)
+                        clusters[i * numCoords + k] = newClusters[i * numCoords + k] / newClusterSize[i];
                 }
             }
-        }
+
+            // everybody is done reading the local arrays: each thread zeroes its own
+            memset(local_newClusterSize[tid], 0, numClusters * sizeof(**local_newClusterSize));
+            memset(local_newClusters[tid], 0, numClusters * numCoords * sizeof(**local_newClusters));
+        } // end of #pragma omp parallel
+        // clang-format on
+
+        if (bnd)
+            bounds_account(bnd, ndist);
 
         // Get fraction of objects whose membership changed during this loop. This is used as a
         // convergence criterion.
@@ -165,12 +353,15 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
     } while (delta > threshold && loop < loop_threshold);
 
     timing = wtime() - timing;
-    printf("nthreads = %2d, nloops = %3d, total = %7.4fs, per loop = %7.4fs, numa = %s\n",
+    printf("nthreads = %2d, nloops = %3d, total = %7.4fs, per loop = %7.4fs, numa = %s, dist = %s\n",
            nthreads,
            loop,
            timing,
            timing / loop,
-           numa_aware);
+           numa_aware,
+           bnd ? "scalar" : dist ? dist->name : "scalar");
+    if (bnd)
+        printf("bounds = %s, distances skipped = %.2f%%\n", bounds_name(bnd), 100.0 * bounds_skipped(bnd));
 
     for (k = 0; k < nthreads; k++) {
         free(local_newClusterSize[k]);
@@ -178,4 +369,8 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
     }
     free(newClusters);
     free(newClusterSize);
+    if (dist)
+        dist_free(dist);
+    if (bnd)
+        bounds_free(bnd);
 }
\ No newline at end of file
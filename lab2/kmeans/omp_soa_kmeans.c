@@ -0,0 +1,225 @@
+#include "kmeans.h"
+#include "layout.h"
+#include "placement.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <omp.h>
+
+extern const char numa_aware[];
+
+/*
+ * Structure-of-arrays reduction k-means (see layout.h). The objects are transposed once to
+ * dimObjects[numCoords][numObjs]; a block of OBJ_BLOCK consecutive objects then has each of its
+ * coordinates in one contiguous row, and its distances to a centroid are accumulated a coordinate
+ * at a time across the whole block, one object per SIMD lane.
+ */
+
+#define TRANSPOSE_TILE 8 // coordinates per tile: one cache line of a row of objects[]
+
+void layout_transpose(const double* objects, int numObjs, int numCoords, double* dimObjects) {
+    int b;
+
+    // clang-format off
+    #pragma omp parallel for schedule(static)
+    // clang-format on
+    for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+        int n = (numObjs - b < OBJ_BLOCK) ? numObjs - b : OBJ_BLOCK;
+        int i, j, jb, m;
+
+        for (jb = 0; jb < numCoords; jb += TRANSPOSE_TILE) {
+            m = (numCoords - jb < TRANSPOSE_TILE) ? numCoords - jb : TRANSPOSE_TILE;
+            for (j = jb; j < jb + m; j++)
+                for (i = b; i < b + n; i++)
+                    dimObjects[(long)j * numObjs + i] = objects[(long)i * numCoords + j];
+        }
+    }
+}
+
+/*
+ * Nearest centroid of the n objects starting at b. The distances are summed in the order of
+ * euclid_dist_2 and ties go to the lowest index, so the result is that of the scalar search.
+ * Compiled for AVX-512, AVX2 and baseline x86-64, the best one being picked at load time, since
+ * the build has no -march.
+ */
+__attribute__((target_clones("avx512f", "avx2", "default"))) static void
+nearest_block(const double* dimObjects, /* [numCoords][numObjs] */
+              int           numObjs,
+              int           b,
+              int           n,
+              int           numCoords,
+              const double* clusters, /* [numClusters][numCoords] */
+              int           numClusters,
+              int*          nearest)  /* out: [n] */
+{
+    // the index is kept in a double so that it has the lane width of the distances
+    double best[OBJ_BLOCK] __attribute__((aligned(64)));
+    double best_idx[OBJ_BLOCK] __attribute__((aligned(64)));
+    double dist[OBJ_BLOCK] __attribute__((aligned(64)));
+    int    p, j, k;
+
+    for (p = 0; p < n; p++) {
+        best[p]     = DBL_MAX;
+        best_idx[p] = 0.0;
+    }
+
+    for (k = 0; k < numClusters; k++) {
+        const double* c = &clusters[k * numCoords];
+
+        for (p = 0; p < n; p++)
+            dist[p] = 0.0;
+        for (j = 0; j < numCoords; j++) {
+            const double* x  = &dimObjects[(long)j * numObjs + b];
+            double        cj = c[j];
+
+            // clang-format off
+            #pragma omp simd aligned(dist : 64)
+            // clang-format on
+            for (p = 0; p < n; p++)
+                dist[p] += (x[p] - cj) * (x[p] - cj);
+        }
+
+        // clang-format off
+        #pragma omp simd aligned(dist, best, best_idx : 64)
+        // clang-format on
+        for (p = 0; p < n; p++) {
+            int less = dist[p] < best[p];
+
+            best_idx[p] = less ? (double)k : best_idx[p];
+            best[p]     = less ? dist[p] : best[p];
+        }
+    }
+
+    for (p = 0; p < n; p++)
+        nearest[p] = (int)best_idx[p];
+}
+
+void kmeans_soa(double* objects,        /* in: [numObjs][numCoords] */
+                int     numCoords,      /* no. coordinates */
+                int     numObjs,        /* no. objects */
+                int     numClusters,    /* no. clusters */
+                double  threshold,      /* minimum fraction of objects that change membership */
+                long    loop_threshold, /* maximum number of iterations */
+                int*    membership,     /* out: [numObjs] */
+                double* clusters)       /* out: [numClusters][numCoords] */
+{
+    int    i, j, k;
+    int    loop = 0;
+    double timing = 0, transpose;
+
+    double  delta;      // fraction of objects whose clusters change in each loop
+    int     nthreads;   // no. threads
+    int     b;          // first object of the current block
+    double* dimObjects; // [numCoords][numObjs]
+
+    nthreads = omp_get_max_threads();
+    LOG("OpenMP Kmeans - Reduction, soa\t(number of threads: %d)\n", nthreads);
+
+    transpose  = wtime();
+    dimObjects = (typeof(dimObjects))placement_alloc((size_t)numObjs * numCoords * sizeof(*dimObjects));
+    layout_transpose(objects, numObjs, numCoords, dimObjects);
+    transpose = wtime() - transpose;
+
+    for (i = 0; i < numObjs; i++)
+        membership[i] = -1;
+
+    // per-thread accumulators, cache-line aligned and first touched by their thread
+    int*    local_newClusterSize[nthreads]; // [nthreads][numClusters]
+    double* local_newClusters[nthreads];    // [nthreads][numClusters][numCoords]
+
+    // clang-format off
+    #pragma omp parallel for schedule(static)
+    // clang-format on
+    for (k = 0; k < nthreads; k++) {
+        size_t sizeBytes = (numClusters * sizeof(**local_newClusterSize) + 63) & ~(size_t)63;
+        size_t dataBytes = (numClusters * numCoords * sizeof(**local_newClusters) + 63) & ~(size_t)63;
+
+        if (posix_memalign((void**)&local_newClusterSize[k], 64, sizeBytes) ||
+            posix_memalign((void**)&local_newClusters[k], 64, dataBytes)) {
+            fprintf(stderr, "Out of memory.\n");
+            exit(1);
+        }
+        memset(local_newClusterSize[k], 0, sizeBytes);
+        memset(local_newClusters[k], 0, dataBytes);
+    }
+
+    timing = wtime();
+    do {
+        delta = 0.0;
+
+        // clang-format off
+        #pragma omp parallel shared(dimObjects, clusters, membership, local_newClusters, local_newClusterSize)
+        {
+            int tid = omp_get_thread_num();
+            int nearest[OBJ_BLOCK];
+            int n;
+
+            #pragma omp for private(i, j, n) schedule(static) reduction(+ : delta)
+            for (b = 0; b < numObjs; b += OBJ_BLOCK) {
+                n = (numObjs - b < OBJ_BLOCK) ? numObjs - b : OBJ_BLOCK;
+                nearest_block(dimObjects, numObjs, b, n, numCoords, clusters, numClusters, nearest);
+
+                for (i = b; i < b + n; i++) {
+                    int index = nearest[i - b];
+
+                    if (membership[i] != index)
+                        delta += 1.0;
+                    membership[i] = index;
+
+                    local_newClusterSize[tid][index]++;
+                    for (j = 0; j < numCoords; j++)
+                        local_newClusters[tid][index * numCoords + j] += dimObjects[(long)j * numObjs + i];
+                }
+            }
+
+            // Reduction with the clusters partitioned across the threads, as in the aos path.
+            #pragma omp for private(i, j, k) schedule(static)
+            for (i = 0; i < numClusters; i++) {
+                int size = 0;
+
+                for (j = 0; j < nthreads; j++)
+                    size += local_newClusterSize[j][i];
+                if (size == 0)
+                    continue;
+
+                for (k = 0; k < numCoords; k++) {
+                    double sum = 0.0;
+
+                    for (j = 0; j < nthreads; j++)
+                        sum += local_newClusters[j][i * numCoords + k];
+                    clusters[i * numCoords + k] = sum / size;
+                }
+            }
+
+            // everybody is done reading the local arrays: each thread zeroes its own
+            memset(local_newClusterSize[tid], 0, numClusters * sizeof(**local_newClusterSize));
+            memset(local_newClusters[tid], 0, numClusters * numCoords * sizeof(**local_newClusters));
+        } // end of #pragma omp parallel
+        // clang-format on
+
+        delta /= numObjs;
+
+        loop++;
+        LOG("\r\tcompleted loop %d", loop);
+        LOG_FLUSH();
+
+    } while (delta > threshold && loop < loop_threshold);
+
+    timing = wtime() - timing;
+    printf("nthreads = %2d, nloops = %3d, total = %7.4fs, per loop = %7.4fs, numa = %s, layout = soa, "
+           "transpose = %7.4fs\n",
+           nthreads,
+           loop,
+           timing,
+           timing / loop,
+           numa_aware,
+           transpose);
+
+    for (k = 0; k < nthreads; k++) {
+        free(local_newClusterSize[k]);
+        free(local_newClusters[k]);
+    }
+    free(dimObjects);
+}
@@ -0,0 +1,382 @@
+#include "kmeans.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <omp.h>
+
+/*
+ * Yinyang k-means (Ding et al., "Yinyang K-Means: A Drop-In Replacement of the Classic K-Means
+ * with Consistent Speedup", ICML 2015).
+ *
+ * The centroids are clustered once into numGroups groups. Every object keeps an upper bound on
+ * the distance to its centroid and one lower bound per group, on the distance to the closest
+ * centroid of that group it is not assigned to. After an update the upper bound grows by the
+ * drift of its centroid and every group bound shrinks by the largest drift in the group:
+ *  - global filter: if the upper bound is below all group bounds, the object stays put;
+ *  - group filter:  otherwise only the groups whose bound is below it are searched;
+ *  - local filter:  inside such a group, a centroid whose own bound (the group bound before the
+ *                   update minus its drift) is not below the best distance so far is skipped.
+ * With numGroups around numClusters / 10 this needs a tenth of Elkan's memory and still prunes
+ * most distances for large numClusters. KMEANS_GROUPS overrides the number of groups.
+ *
+ * Memberships are exact, up to ties between equally distant centroids.
+ */
+
+extern const char numa_aware[];
+
+// double precision and aos only: KMEANS_PRECISION, KMEANS_LAYOUT and KMEANS_VALIDATE are refused
+const int kmeans_variants = 0;
+
+// Lloyd iterations used to group the initial centroids.
+#define GROUP_ITERS 5
+
+// distance (not squared) between two multi-dimensional points
+inline static double euclid_dist(int     numdims, /* no. dimensions */
+                                 double* coord1,  /* [numdims] */
+                                 double* coord2)  /* [numdims] */
+{
+    int    i;
+    double ans = 0.0;
+
+    for (i = 0; i < numdims; i++)
+        ans += (coord1[i] - coord2[i]) * (coord1[i] - coord2[i]);
+
+    return sqrt(ans);
+}
+
+/*
+ * Group the centroids with a few Lloyd iterations over them, seeded with the first numGroups.
+ * groupMembers lists the centroids of group g in groupMembers[groupStart[g] .. groupStart[g+1]).
+ */
+static void group_centroids(int     numClusters,
+                            int     numCoords,
+                            int     numGroups,
+                            double* clusters,     /* in: [numClusters][numCoords] */
+                            int*    groupOf,      /* out: [numClusters] */
+                            int*    groupStart,   /* out: [numGroups + 1] */
+                            int*    groupMembers) /* out: [numClusters] */
+{
+    double* centers = (typeof(centers))malloc(numGroups * numCoords * sizeof(*centers));
+    int*    count   = (typeof(count))calloc(numGroups, sizeof(*count));
+    int     it, i, j, g;
+    double  d, best;
+
+    memcpy(centers, clusters, numGroups * numCoords * sizeof(*centers));
+    for (it = 0; it < GROUP_ITERS; it++) {
+        for (i = 0; i < numClusters; i++) {
+            best = DBL_MAX;
+            for (g = 0; g < numGroups; g++) {
+                d = euclid_dist(numCoords, &clusters[i * numCoords], &centers[g * numCoords]);
+                if (d < best) {
+                    best       = d;
+                    groupOf[i] = g;
+                }
+            }
+        }
+        memset(centers, 0, numGroups * numCoords * sizeof(*centers));
+        memset(count, 0, numGroups * sizeof(*count));
+        for (i = 0; i < numClusters; i++) {
+            count[groupOf[i]]++;
+            for (j = 0; j < numCoords; j++)
+                centers[groupOf[i] * numCoords + j] += clusters[i * numCoords + j];
+        }
+        for (g = 0; g < numGroups; g++) {
+            if (count[g] > 0) {
+                for (j = 0; j < numCoords; j++)
+                    centers[g * numCoords + j] /= count[g];
+            } else {
+                // keep empty groups alive around a centroid
+                memcpy(&centers[g * numCoords], &clusters[g * numCoords], numCoords * sizeof(*centers));
+            }
+        }
+    }
+
+    // counting sort of the centroids by group
+    groupStart[0] = 0;
+    for (g = 0; g < numGroups; g++)
+        groupStart[g + 1] = groupStart[g] + count[g];
+    memcpy(count, groupStart, numGroups * sizeof(*count));
+    for (i = 0; i < numClusters; i++)
+        groupMembers[count[groupOf[i]]++] = i;
+
+    free(centers);
+    free(count);
+}
+
+// Full search of object i, which also initialises its bounds.
+static int assign_full(int     numClusters,
+                       int     numCoords,
+                       int     numGroups,
+                       double* object,
+                       double* clusters,
+                       int*    groupOf,
+                       double* upper, /* out: upper bound of the object */
+                       double* lower) /* out: [numGroups] */
+{
+    int    j, g, index = 0;
+    double d, best = DBL_MAX;
+
+    for (g = 0; g < numGroups; g++)
+        lower[g] = DBL_MAX;
+    for (j = 0; j < numClusters; j++) {
+        d = euclid_dist(numCoords, object, &clusters[j * numCoords]);
+        if (d < best) {
+            if (best < lower[groupOf[index]])
+                lower[groupOf[index]] = best;
+            best  = d;
+            index = j;
+        } else if (d < lower[groupOf[j]]) {
+            lower[groupOf[j]] = d;
+        }
+    }
+    *upper = best;
+    return index;
+}
+
+void kmeans(double* objects,        /* in: [numObjs][numCoords] */
+            int     numCoords,      /* no. coordinates */
+            int     numObjs,        /* no. objects */
+            int     numClusters,    /* no. clusters */
+            double  threshold,      /* minimum fraction of objects that change membership */
+            long    loop_threshold, /* maximum number of iterations */
+            int*    membership,     /* out: [numObjs] */
+            double* clusters)       /* out: [numClusters][numCoords] */
+{
+    int    i, j, k, g;
+    int    loop = 0;
+    double timing = 0;
+
+    double    delta;          // fraction of objects whose clusters change in each loop
+    int*      newClusterSize; // [numClusters]: no. objects assigned in each new cluster
+    double*   newClusters;    // [numClusters][numCoords]
+    int       nthreads;       // no. threads
+    int       numGroups;      // no. centroid groups
+    int*      groupOf;        // [numClusters]: group of every centroid
+    int*      groupStart;     // [numGroups + 1]
+    int*      groupMembers;   // [numClusters]: centroids sorted by group
+    double*   upper;          // [numObjs]: upper bound on the distance to the own centroid
+    double*   lower;          // [numObjs][numGroups]: lower bounds per group
+    double*   oldClusters;    // [numClusters][numCoords]: centroids before the update
+    double*   drift;          // [numClusters]: how far every centroid moved
+    double*   groupDrift;     // [numGroups]: largest drift in every group
+    long long ndist, computed = 0, possible = 0;
+    char*     env;
+
+    nthreads = omp_get_max_threads();
+    LOG("OpenMP Kmeans - Yinyang\t(number of threads: %d)\n", nthreads);
+
+    numGroups = numClusters / 10;
+    if ((env = getenv("KMEANS_GROUPS")))
+        numGroups = atoi(env);
+    if (numGroups < 1)
+        numGroups = 1;
+    if (numGroups > numClusters)
+        numGroups = numClusters;
+
+    // initialize membership
+    for (i = 0; i < numObjs; i++)
+        membership[i] = -1;
+
+    // initialize newClusterSize and newClusters to all 0
+    newClusterSize = (typeof(newClusterSize))calloc(numClusters, sizeof(*newClusterSize));
+    newClusters    = (typeof(newClusters))calloc(numClusters * numCoords, sizeof(*newClusters));
+
+    groupOf      = (typeof(groupOf))malloc(numClusters * sizeof(*groupOf));
+    groupStart   = (typeof(groupStart))malloc((numGroups + 1) * sizeof(*groupStart));
+    groupMembers = (typeof(groupMembers))malloc(numClusters * sizeof(*groupMembers));
+    upper        = (typeof(upper))malloc(numObjs * sizeof(*upper));
+    lower        = (typeof(lower))malloc((size_t)numObjs * numGroups * sizeof(*lower));
+    oldClusters  = (typeof(oldClusters))malloc(numClusters * numCoords * sizeof(*oldClusters));
+    drift        = (typeof(drift))calloc(numClusters, sizeof(*drift));
+    groupDrift   = (typeof(groupDrift))calloc(numGroups, sizeof(*groupDrift));
+    if (!groupOf || !groupStart || !groupMembers || !upper || !lower || !oldClusters) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+
+    // Each thread calculates new centers using a private space. After that, all threads reduce
+    // them, each one a share of the clusters.
+    int*    local_newClusterSize[nthreads]; // [nthreads][numClusters]
+    double* local_newClusters[nthreads];    // [nthreads][numClusters][numCoords]
+
+    for (k = 0; k < nthreads; k++) {
+        local_newClusterSize[k] =
+          (typeof(*local_newClusterSize))calloc(numClusters, sizeof(**local_newClusterSize));
+        local_newClusters[k] =
+          (typeof(*local_newClusters))calloc(numClusters * numCoords, sizeof(**local_newClusters));
+    }
+
+    timing = wtime();
+    group_centroids(numClusters, numCoords, numGroups, clusters, groupOf, groupStart, groupMembers);
+    do {
+        delta = 0.0;
+        ndist = 0;
+
+        // clang-format off
+        #pragma omp parallel private(i, j, g)
+        {
+            int tid = omp_get_thread_num();
+
+            #pragma omp for schedule(static) reduction(+ : delta, ndist)
+            for (i = 0; i < numObjs; i++) {
+                double* object = &objects[i * numCoords];
+                double* lb     = &lower[(long)i * numGroups];
+                int     a      = membership[i];
+                int     index, m, bg;
+                double  d, globalLower, prevLower, newLower, best;
+
+                if (a < 0) {
+                    index = assign_full(numClusters, numCoords, numGroups, object, clusters, groupOf, &upper[i], lb);
+                    ndist += numClusters;
+                    goto assigned;
+                }
+
+                // global filter
+                upper[i] += drift[a];
+                globalLower = DBL_MAX;
+                for (g = 0; g < numGroups; g++) {
+                    lb[g] -= groupDrift[g];
+                    if (lb[g] < globalLower)
+                        globalLower = lb[g];
+                }
+                index = a;
+                if (upper[i] <= globalLower)
+                    goto assigned;
+                upper[i] = euclid_dist(numCoords, object, &clusters[a * numCoords]);
+                ndist++;
+                if (upper[i] <= globalLower)
+                    goto assigned;
+
+                // group and local filters
+                best = upper[i];
+                for (g = 0; g < numGroups; g++) {
+                    if (lb[g] >= best)
+                        continue;
+                    prevLower = lb[g] + groupDrift[g];
+                    newLower  = DBL_MAX;
+                    for (m = groupStart[g]; m < groupStart[g + 1]; m++) {
+                        j = groupMembers[m];
+                        if (j == index)
+                            continue;
+                        if (j == a) {
+                            // the old centroid lost to another one; its distance is exact
+                            if (upper[i] < newLower)
+                                newLower = upper[i];
+                            continue;
+                        }
+                        if (prevLower - drift[j] >= best) {
+                            if (prevLower - drift[j] < newLower)
+                                newLower = prevLower - drift[j];
+                            continue;
+                        }
+                        d = euclid_dist(numCoords, object, &clusters[j * numCoords]);
+                        ndist++;
+                        if (d < best || (d == best && j < index)) {
+                            // the previous best becomes a bound of its own group
+                            bg = groupOf[index];
+                            if (bg == g) {
+                                if (best < newLower)
+                                    newLower = best;
+                            } else if (best < lb[bg]) {
+                                lb[bg] = best;
+                            }
+                            best  = d;
+                            index = j;
+                        } else if (d < newLower) {
+                            newLower = d;
+                        }
+                    }
+                    lb[g] = newLower;
+                }
+                upper[i] = best;
+
+            assigned:
+                // if membership changes, increase delta by 1
+                if (membership[i] != index)
+                    delta += 1.0;
+
+                // assign the membership to object i
+                membership[i] = index;
+
+                // update new cluster centers : sum of all objects located within
+                local_newClusterSize[tid][index]++;
+                for (j = 0; j < numCoords; j++)
+                    local_newClusters[tid][index * numCoords + j] += object[j];
+            }
+
+            // reduction of the per-thread cluster data, clusters partitioned across the threads
+            #pragma omp for private(k) schedule(static)
+            for (i = 0; i < numClusters; i++) {
+                newClusterSize[i] = 0;
+                for (k = 0; k < numCoords; k++)
+                    newClusters[i * numCoords + k] = 0.0;
+                for (j = 0; j < nthreads; j++) {
+                    newClusterSize[i] += local_newClusterSize[j][i];
+                    for (k = 0; k < numCoords; k++)
+                        newClusters[i * numCoords + k] += local_newClusters[j][i * numCoords + k];
+                }
+
+                // average the sum and replace old cluster centers with newClusters
+                memcpy(&oldClusters[i * numCoords], &clusters[i * numCoords], numCoords * sizeof(*clusters));
+                if (newClusterSize[i] > 0) {
+                    for (k = 0; k < numCoords; k++)
+                        clusters[i * numCoords + k] = newClusters[i * numCoords + k] / newClusterSize[i];
+                }
+                drift[i] = euclid_dist(numCoords, &clusters[i * numCoords], &oldClusters[i * numCoords]);
+            }
+
+            // everybody is done reading the local arrays: each thread zeroes its own
+            memset(local_newClusterSize[tid], 0, numClusters * sizeof(**local_newClusterSize));
+            memset(local_newClusters[tid], 0, numClusters * numCoords * sizeof(**local_newClusters));
+        } // end of #pragma omp parallel
+        // clang-format on
+
+        computed += ndist;
+        possible += (long long)numObjs * numClusters;
+
+        // largest drift of every group
+        for (g = 0; g < numGroups; g++)
+            groupDrift[g] = 0.0;
+        for (i = 0; i < numClusters; i++) {
+            if (drift[i] > groupDrift[groupOf[i]])
+                groupDrift[groupOf[i]] = drift[i];
+        }
+
+        // Get fraction of objects whose membership changed during this loop. This is used as a
+        // convergence criterion.
+        delta /= numObjs;
+
+        loop++;
+        LOG("\r\tcompleted loop %d", loop);
+        LOG_FLUSH();
+
+    } while (delta > threshold && loop < loop_threshold);
+
+    timing = wtime() - timing;
+    printf("nthreads = %2d, nloops = %3d, total = %7.4fs, per loop = %7.4fs, numa = %s, groups = %d, distances skipped = %.2f%%\n",
+           nthreads,
+           loop,
+           timing,
+           timing / loop,
+           numa_aware,
+           numGroups,
+           possible ? 100.0 * (1.0 - (double)computed / possible) : 0.0);
+
+    for (k = 0; k < nthreads; k++) {
+        free(local_newClusterSize[k]);
+        free(local_newClusters[k]);
+    }
+    free(groupOf);
+    free(groupStart);
+    free(groupMembers);
+    free(upper);
+    free(lower);
+    free(oldClusters);
+    free(drift);
+    free(groupDrift);
+    free(newClusters);
+    free(newClusterSize);
+}
@@ -0,0 +1,114 @@
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "placement.h"
+
+#define MPOL_INTERLEAVE 3  /* from <linux/mempolicy.h> */
+#define MAX_NODES       64 /* one unsigned long of node mask */
+#define QUERY_PAGES     1024
+
+static int nodes;
+
+int placement_nodes(void) {
+    char path[64];
+
+    if (nodes)
+        return nodes;
+    while (nodes < MAX_NODES) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", nodes);
+        if (access(path, F_OK))
+            break;
+        nodes++;
+    }
+    if (!nodes)
+        nodes = 1;
+    return nodes;
+}
+
+int placement_current_node(void) {
+    unsigned int cpu, node;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL))
+        return -1;
+    return (int)node;
+}
+
+static int interleave_requested(void) {
+    char* env = getenv("KMEANS_NUMA");
+
+    if (!env || !strcmp(env, "firsttouch"))
+        return 0;
+    if (!strcmp(env, "interleave"))
+        return 1;
+    fprintf(stderr, "Unknown KMEANS_NUMA '%s' (firsttouch or interleave).\n", env);
+    exit(1);
+}
+
+void* placement_alloc(size_t size) {
+    long          page = sysconf(_SC_PAGESIZE);
+    unsigned long mask;
+    void*         addr;
+    size_t        len;
+
+    len = (size + page - 1) / page * page;
+    if (posix_memalign(&addr, page, len)) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+
+    if (interleave_requested() && placement_nodes() > 1) {
+        mask = (placement_nodes() == MAX_NODES) ? ~0UL : (1UL << placement_nodes()) - 1;
+        if (syscall(SYS_mbind, addr, len, MPOL_INTERLEAVE, &mask, 8 * sizeof(mask) + 1, 0))
+            perror("mbind");
+    }
+    return addr;
+}
+
+void placement_count(const void* addr, size_t len, long* pages) {
+    long        page  = sysconf(_SC_PAGESIZE);
+    const char* start = (const char*)((unsigned long)addr & ~(page - 1));
+    const char* end   = (const char*)addr + len;
+    void*       query[QUERY_PAGES];
+    int         status[QUERY_PAGES];
+    int         n, i;
+
+    while (start < end) {
+        for (n = 0; n < QUERY_PAGES && start < end; n++, start += page)
+            query[n] = (void*)start;
+        // with no target nodes, move_pages() only reports where the pages are
+        if (syscall(SYS_move_pages, 0, n, query, NULL, status, 0)) {
+            pages[placement_nodes()] += n;
+            continue;
+        }
+        for (i = 0; i < n; i++) {
+            if (status[i] >= 0 && status[i] < placement_nodes())
+                pages[status[i]]++;
+            else
+                pages[placement_nodes()]++;
+        }
+    }
+}
+
+void placement_print(const char* what, const long* pages) {
+    long total = 0;
+    int  i;
+
+    for (i = 0; i <= placement_nodes(); i++)
+        total += pages[i];
+    printf("placement %s: %ld pages,", what, total);
+    for (i = 0; i < placement_nodes(); i++)
+        printf(" node%d %.1f%%", i, total ? 100.0 * pages[i] / total : 0.0);
+    if (pages[placement_nodes()])
+        printf(" not present %.1f%%", 100.0 * pages[placement_nodes()] / total);
+    printf("\n");
+}
+
+int placement_report(void) {
+    return getenv("KMEANS_NUMA_REPORT") != NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef _H_PLACEMENT
+#define _H_PLACEMENT
+
+#include <stddef.h>
+
+/*
+ * NUMA page placement without libnuma: mbind(2), move_pages(2) and getcpu(2) are called through
+ * syscall(2), and the number of nodes is read from sysfs.
+ *
+ *   KMEANS_NUMA=firsttouch   (default) pages go to the node of the thread that first writes them
+ *   KMEANS_NUMA=interleave   the dataset is interleaved page by page across all nodes
+ *   KMEANS_NUMA_REPORT=1     print where the pages of the dataset and the accumulators ended up
+ */
+
+// Number of NUMA nodes (1 if unknown).
+int placement_nodes(void);
+
+// Node of the CPU the calling thread runs on, -1 if unknown.
+int placement_current_node(void);
+
+/*
+ * Page-aligned allocation for data whose placement matters. With KMEANS_NUMA=interleave the range
+ * is interleaved across all nodes before anything touches it. Release with free().
+ */
+void* placement_alloc(size_t size);
+
+/*
+ * Add the pages of [addr, addr + len) to pages[node]; pages[placement_nodes()] counts pages that
+ * are not present yet or whose node is unknown.
+ */
+void placement_count(const void* addr, size_t len, long* pages); /* [placement_nodes() + 1] */
+
+// Print a pages[] histogram filled by placement_count().
+void placement_print(const char* what, const long* pages);
+
+// Non-zero if KMEANS_NUMA_REPORT is set.
+int placement_report(void);
+
+#endif
@@ -0,0 +1,78 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "precision.h"
+
+static const char* precision_names[] = { "double", "float", "float-kahan" };
+
+static int         precision_known;
+static precision_t precision;
+
+precision_t precision_get(void) {
+    char* env;
+    int   i;
+
+    if (precision_known)
+        return precision;
+
+    precision_known = 1;
+    precision       = PRECISION_DOUBLE;
+    if (!(env = getenv("KMEANS_PRECISION")))
+        return precision;
+    for (i = 0; i < (int)(sizeof(precision_names) / sizeof(precision_names[0])); i++) {
+        if (!strcmp(env, precision_names[i])) {
+            precision = (precision_t)i;
+            return precision;
+        }
+    }
+    fprintf(stderr, "Unknown KMEANS_PRECISION '%s' (double, float or float-kahan).\n", env);
+    exit(1);
+}
+
+void precision_set(precision_t p) {
+    precision_known = 1;
+    precision       = p;
+}
+
+const char* precision_name(precision_t p) {
+    return precision_names[p];
+}
+
+double precision_validation_eps(void) {
+    char*  env = getenv("KMEANS_VALIDATE");
+    double eps;
+
+    if (!env)
+        return 0.0;
+    eps = atof(env);
+    return eps > 0.0 ? eps : 1e-2;
+}
+
+double precision_compare(const double* ref, const double* clusters, int numClusters, int numCoords) {
+    double worst = 0.0, best, dist, norm, d;
+    int    i, k, j;
+
+    for (i = 0; i < numClusters; i++) {
+        best = DBL_MAX;
+        for (k = 0; k < numClusters; k++) {
+            dist = 0.0;
+            for (j = 0; j < numCoords; j++) {
+                d = ref[i * numCoords + j] - clusters[k * numCoords + j];
+                dist += d * d;
+            }
+            if (dist < best)
+                best = dist;
+        }
+
+        norm = 0.0;
+        for (j = 0; j < numCoords; j++)
+            norm += ref[i * numCoords + j] * ref[i * numCoords + j];
+        d = norm > 0.0 ? sqrt(best / norm) : sqrt(best);
+        if (d > worst)
+            worst = d;
+    }
+    return worst;
+}
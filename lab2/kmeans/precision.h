@@ -0,0 +1,55 @@
+#ifndef _H_PRECISION
+#define _H_PRECISION
+
+/*
+ * Storage and compute precision of the reduction k-means, picked with
+ * KMEANS_PRECISION=double|float|float-kahan (default double):
+ *
+ *  - double:      the original code path.
+ *  - float:       objects and centroids are stored and compared in float32, which halves the
+ *                 bytes streamed per loop and doubles the SIMD width of the distances. The new
+ *                 centroids are still accumulated in double, so they do not drift with numObjs.
+ *  - float-kahan: as float, but the accumulators are float32 with Kahan compensation.
+ *
+ * The float paths have no soa layout and no bounds: KMEANS_PRECISION=float|float-kahan together
+ * with KMEANS_LAYOUT=soa or KMEANS_BOUNDS is an error, not a silent choice of one of them. So are
+ * KMEANS_PRECISION, KMEANS_LAYOUT and KMEANS_VALIDATE in binaries other than the reduction ones
+ * (see kmeans_variants in kmeans.h).
+ *
+ * KMEANS_VALIDATE=eps, with a float precision or KMEANS_LAYOUT=soa, runs the double aos path
+ * again from the same initial centers and checks that every centroid is within a relative distance
+ * eps (1e-2 if empty) of one of the computed ones, like VALIDATE in lab3/main_gpu.cu. Objects
+ * close to a boundary can pick another center in float, so the two runs drift apart with the
+ * number of loops and many clusters may need a larger eps.
+ */
+
+typedef enum { PRECISION_DOUBLE = 0, PRECISION_FLOAT, PRECISION_FLOAT_KAHAN } precision_t;
+
+precision_t precision_get(void);
+void        precision_set(precision_t p); // overrides KMEANS_PRECISION
+const char* precision_name(precision_t p);
+
+// Validation tolerance from KMEANS_VALIDATE, or 0 if validation is off.
+double precision_validation_eps(void);
+
+/*
+ * Match every reference centroid to the closest computed one and return the largest relative
+ * distance between them, ||ref - c|| / ||ref||.
+ */
+double precision_compare(const double* ref,      /* [numClusters][numCoords] */
+                         const double* clusters, /* [numClusters][numCoords] */
+                         int           numClusters,
+                         int           numCoords);
+
+// The float and float-kahan paths of kmeans() in omp_float_kmeans.c.
+void kmeans_float(double*     objects,
+                  int         numCoords,
+                  int         numObjs,
+                  int         numClusters,
+                  double      threshold,
+                  long        loop_threshold,
+                  int*        membership,
+                  double*     clusters,
+                  precision_t p);
+
+#endif
@@ -67,3 +67,113 @@ do
     export  OMP_NUM_THREADS=$i
     ./kmeans_omp_reduction_numa_aware_io -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/reduction_small.out
 done
+
+
+# Compare the distance kernels (see distance.h) on the {256, 16, 32, 10} configuration
+SIZE=256
+COORDS=16
+CLUSTERS=32
+LOOPS=10
+> ./results/reduction_dist.out
+
+for dist in scalar generic avx2 avx512
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        export  OMP_NUM_THREADS=$i
+        KMEANS_DIST=$dist ./kmeans_omp_reduction -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/reduction_dist.out
+    done
+done
+
+
+# Triangle-inequality pruning (see bounds.h); run to convergence, where it pays off the most
+> ./results/reduction_bounds.out
+
+for bounds in hamerly elkan
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        export  OMP_NUM_THREADS=$i
+        KMEANS_BOUNDS=$bounds ./kmeans_omp_reduction -s $SIZE -n $COORDS -c $CLUSTERS -l 100 1>>./results/reduction_bounds.out
+    done
+done
+
+
+# Yinyang k-means for large numbers of clusters, against the reduction version
+> ./results/yinyang.out
+
+for clusters in 256 1024
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        export  OMP_NUM_THREADS=$i
+        ./kmeans_omp_reduction -s $SIZE -n $COORDS -c $clusters -l 100 1>>./results/yinyang.out
+        ./kmeans_omp_yinyang -s $SIZE -n $COORDS -c $clusters -l 100 1>>./results/yinyang.out
+    done
+done
+
+
+# Page placement of the dataset: first touch by the computing threads vs interleaved (see placement.h)
+SIZE=256
+COORDS=16
+CLUSTERS=32
+> ./results/reduction_placement.out
+
+for numa in firsttouch interleave
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        export  OMP_NUM_THREADS=$i
+        KMEANS_NUMA=$numa KMEANS_NUMA_REPORT=1 ./kmeans_omp_reduction_numa_aware_io -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/reduction_placement.out
+    done
+done
+
+
+# Mini-batch k-means on a streamed dataset far larger than memory, for a few batch sizes
+> ./results/minibatch.out
+
+for batch in 1024 4096 16384
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        export  OMP_NUM_THREADS=$i
+        ./kmeans_omp_minibatch -s 1048576 -n $COORDS -c $CLUSTERS -b $batch -l 1000 1>>./results/minibatch.out
+    done
+done
+
+
+# Storage precision of the reduction version (see precision.h), checked against the double path
+SIZE=256
+COORDS=16
+CLUSTERS=32
+> ./results/reduction_precision.out
+
+for precision in double float float-kahan
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        export  OMP_NUM_THREADS=$i
+        if [ $precision = double ]
+        then
+            ./kmeans_omp_reduction -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/reduction_precision.out
+        else
+            KMEANS_PRECISION=$precision KMEANS_VALIDATE= ./kmeans_omp_reduction -s $SIZE -n $COORDS -c $CLUSTERS -l $LOOPS 1>>./results/reduction_precision.out
+        fi
+    done
+done
+
+
+# Object layout (see layout.h): the transposed soa path against aos, for small numCoords
+> ./results/reduction_layout.out
+
+for coords in 1 2 4 16
+do
+    for layout in aos soa
+    do
+        for i in 1 2 4 8 16 32 64
+        do
+            export  OMP_NUM_THREADS=$i
+            KMEANS_LAYOUT=$layout ./kmeans_omp_reduction -s $SIZE -n $coords -c $CLUSTERS -l $LOOPS 1>>./results/reduction_layout.out
+        done
+    done
+done
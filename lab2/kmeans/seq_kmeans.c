@@ -2,6 +2,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// double precision and aos only: KMEANS_PRECISION, KMEANS_LAYOUT and KMEANS_VALIDATE are refused
+const int kmeans_variants = 0;
+
 // square of Euclid distance between two multi-dimensional points
 inline static double euclid_dist_2(int     numdims, /* no. dimensions */
                                    double* coord1,  /* [numdims] */
@@ -40,6 +43,71 @@ inline static int find_nearest_cluster(int     numClusters, /* no. clusters */
     return index;
 }
 
+/*
+ * One assignment pass over all objects, accumulating the new cluster sums; returns the number of
+ * membership changes. It is generated for a few numCoords known at compile time, where the
+ * distance and accumulation loops are fully unrolled and euclid_dist_2 inlines to straight-line
+ * code, as in lab3/seq_kmeans.c. The sums are formed in the same order, so every version gives
+ * identical results.
+ */
+#define KMEANS_ASSIGN(NAME, DIMS)                                                                  \
+    static double NAME(double* objects,                                                            \
+                       int     numCoords,                                                          \
+                       int     numObjs,                                                            \
+                       int     numClusters,                                                        \
+                       double* clusters,                                                           \
+                       int*    membership,                                                         \
+                       int*    newClusterSize,                                                     \
+                       double* newClusters)                                                        \
+    {                                                                                              \
+        double delta = 0.0;                                                                        \
+        int    i, j, index;                                                                        \
+                                                                                                   \
+        (void)numCoords;                                                                           \
+        for (i = 0; i < numObjs; i++) {                                                            \
+            index = find_nearest_cluster(numClusters, (DIMS), &objects[i * (DIMS)], clusters);     \
+                                                                                                   \
+            if (membership[i] != index)                                                            \
+                delta += 1.0;                                                                      \
+            membership[i] = index;                                                                 \
+                                                                                                   \
+            newClusterSize[index]++;                                                               \
+            for (j = 0; j < (DIMS); j++)                                                           \
+                newClusters[index * (DIMS) + j] += objects[i * (DIMS) + j];                        \
+        }                                                                                          \
+        return delta;                                                                              \
+    }
+
+KMEANS_ASSIGN(assign_generic, numCoords)
+KMEANS_ASSIGN(assign_2, 2)
+KMEANS_ASSIGN(assign_4, 4)
+KMEANS_ASSIGN(assign_8, 8)
+KMEANS_ASSIGN(assign_16, 16)
+KMEANS_ASSIGN(assign_32, 32)
+KMEANS_ASSIGN(assign_64, 64)
+
+typedef double (*assign_fn)(double*, int, int, int, double*, int*, int*, double*);
+
+// pick the specialised pass for numCoords, once per run; other sizes use the generic one
+static assign_fn select_assign(int numCoords) {
+    switch (numCoords) {
+        case 2:
+            return assign_2;
+        case 4:
+            return assign_4;
+        case 8:
+            return assign_8;
+        case 16:
+            return assign_16;
+        case 32:
+            return assign_32;
+        case 64:
+            return assign_64;
+        default:
+            return assign_generic;
+    }
+}
+
 void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             int     numCoords,      /* no. coordinates */
             int     numObjs,        /* no. objects */
@@ -50,12 +118,13 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             double* clusters)       /* out: [numClusters][numCoords] */
 {
     int    i, j;
-    int    index, loop = 0;
+    int    loop = 0;
     double timing = 0;
 
-    double  delta;          // fraction of objects whose clusters change in each loop
-    int*    newClusterSize; // [numClusters]: no. objects assigned in each new cluster
-    double* newClusters;    // [numClusters][numCoords]
+    double    delta;          // fraction of objects whose clusters change in each loop
+    int*      newClusterSize; // [numClusters]: no. objects assigned in each new cluster
+    double*   newClusters;    // [numClusters][numCoords]
+    assign_fn assign = select_assign(numCoords);
 
     LOG("Sequential Kmeans\n");
 
@@ -79,26 +148,14 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             newClusterSize[i] = 0;
         }
 
-        delta = 0.0;
-
-        for (i = 0; i < numObjs; i++) {
-            // find the array index of nearest cluster center
-            index = find_nearest_cluster(numClusters, numCoords, &objects[i * numCoords], clusters);
-
-            // if membership changes, increase delta by 1
-            if (membership[i] != index) {
-                delta += 1.0;
-            }
-
-            // assign the membership to object i
-            membership[i] = index;
-
-            // update new cluster centers : sum of objects located within
-            newClusterSize[index]++;
-            for (j = 0; j < numCoords; j++) {
-                newClusters[index * numCoords + j] += objects[i * numCoords + j];
-            }
-        }
+        delta = assign(objects,
+                       numCoords,
+                       numObjs,
+                       numClusters,
+                       clusters,
+                       membership,
+                       newClusterSize,
+                       newClusters);
 
         // average the sum and replace old cluster centers with newClusters
         for (i = 0; i < numClusters; i++) {
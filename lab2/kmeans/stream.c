@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dataset.h"
+#include "kmeans.h"
+#include "rng.h"
+#include "stream.h"
+
+stream_t* stream_open(long numObjs, int numCoords) {
+    stream_t* s = (typeof(s))malloc(sizeof(*s));
+
+    if (!s) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    s->numObjs   = numObjs;
+    s->numCoords = numCoords;
+    s->batch     = 0;
+    s->ds        = NULL;
+    return s;
+}
+
+stream_t* stream_open_dataset(const dataset_t* ds) {
+    stream_t* s = stream_open(ds->numObjs, ds->numCoords);
+
+    s->ds = ds;
+    return s;
+}
+
+void stream_close(stream_t* s) {
+    free(s);
+}
+
+void stream_next(stream_t* s, double* batch, int n) {
+    long stride = (s->numObjs / n > 0) ? s->numObjs / n : 1;
+    long offset = rng_bits(rng_key(STREAM_SEED, s->batch), 0) % s->numObjs;
+    int  i;
+
+    // clang-format off
+    #pragma omp parallel for schedule(static, OBJ_BLOCK)
+    // clang-format on
+    for (i = 0; i < n; i++) {
+        long k = (offset + i * stride) % s->numObjs;
+
+        if (s->ds)
+            dataset_get(s->ds, k, &batch[(long)i * s->numCoords]);
+        else
+            dataset_object(k, s->numCoords, &batch[(long)i * s->numCoords]);
+    }
+
+    s->batch++;
+}
+
+void stream_rewind(stream_t* s) {
+    s->batch = 0;
+}
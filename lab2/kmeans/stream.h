@@ -0,0 +1,45 @@
+#ifndef _H_STREAM
+#define _H_STREAM
+
+/*
+ * A streaming source of objects for the mini-batch k-means: batches are produced on demand and
+ * only the batch being consumed is in memory, so numObjs is not bounded by RAM. The objects are the
+ * ones dataset_generation() would produce, generated in parallel when compiled with OpenMP, or
+ * those of a binary dataset mapped by dataset_map(), converted to double a batch at a time whatever
+ * the dtype and layout of the file.
+ *
+ * Sculley's update assumes every batch is a random sample of the dataset, and files are often
+ * ordered (by class, by time): consecutive runs of objects would feed the early batches to a few
+ * centers only. Batch t is therefore a systematic sample over the whole dataset, the n objects
+ *
+ *     (offset + i * (numObjs / n)) % numObjs,   i = 0 .. n - 1,
+ *
+ * with offset drawn from the generator of rng.h keyed by (STREAM_SEED, t). A batch has no repeated
+ * objects, the batches are the same from run to run and thread count to thread count, and within
+ * a batch the objects are read in file order. Files are mapped MADV_RANDOM: with a stride of more
+ * than a page, readahead would only read what is not used.
+ */
+
+#define STREAM_SEED 7
+
+struct dataset;
+
+typedef struct stream {
+    long                  numObjs;
+    int                   numCoords;
+    long                  batch; // number of the next batch
+    const struct dataset* ds;    // dataset file, or NULL to generate the objects
+} stream_t;
+
+stream_t* stream_open(long numObjs, int numCoords);
+// Stream the objects of a dataset file mapped by dataset_map().
+stream_t* stream_open_dataset(const struct dataset* ds);
+void      stream_close(stream_t* s);
+
+// Fill batch[n][numCoords] with the n objects of the next batch.
+void stream_next(stream_t* s, double* batch, int n);
+
+// Start over from the first batch.
+void stream_rewind(stream_t* s);
+
+#endif
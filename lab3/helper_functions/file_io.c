@@ -9,11 +9,13 @@
 #include <omp.h>
 
 #include "kmeans.h"
+#include "rng.h"
 
 double * dataset_generation(int numObjs, int numCoords)
 {
     double * objects = NULL;
     long i, j;
+    unsigned long long key = rng_key(DATASET_SEED, 0);
     // Random values that will be generated will be between 0 and 10.
     double val_range = 10;
 
@@ -30,10 +32,9 @@ double * dataset_generation(int numObjs, int numCoords)
     if(!numa_aware){    
         for (i=0; i<numObjs; i++)
         {
-            unsigned int seed = i;
             for (j=0; j<numCoords; j++)
             {
-                objects[i*numCoords + j] = (rand_r(&seed) / ((double) RAND_MAX)) * val_range;
+                objects[i*numCoords + j] = rng_unit(key, (unsigned long long)i*numCoords + j) * val_range;
                 if (_debug && i == 0)
                     printf("object[i=%ld][j=%ld]=%f\n",i,j,objects[i*numCoords + j]);
             }
@@ -46,10 +47,9 @@ double * dataset_generation(int numObjs, int numCoords)
             #pragma omp for schedule(static) 
             for(i=0; i<numObjs; i++)
             {
-                unsigned int seed = i;
                 for (j=0; j<numCoords; j++)
                 {
-                    objects[i*numCoords + j] = (rand_r(&seed) / ((double) RAND_MAX)) * val_range;
+                    objects[i*numCoords + j] = rng_unit(key, (unsigned long long)i*numCoords + j) * val_range;
                 }
             }
         }
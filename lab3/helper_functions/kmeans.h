@@ -7,6 +7,12 @@ void kmeans(double * objects, int numCoords, int numObjs, int numClusters, doubl
 
 void kmeans_gpu(double * objects, int numCoords, int numObjs, int numClusters, double threshold, long loop_threshold, int *membership, double * clusters, int block_size);
 
+/*
+ * Synthetic dataset: coordinate j of object i is draw i * numCoords + j of the counter-based
+ * generator of rng.h (seed DATASET_SEED), scaled to [0, 10); the same data as lab2 and lab4.
+ */
+#define DATASET_SEED 2024
+
 double * dataset_generation(int numObjs, int numCoords);
 
 int check_repeated_clusters(int, int, double*);
@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+#include "rng.h"
+#include "seeding.h"
+
+static const char* seeding_names[] = { "first", "kmeans++", "kmeans||" };
+
+int seeding_parse(const char* name, seeding_t* method) {
+    int i;
+
+    for (i = 0; i < (int)(sizeof(seeding_names) / sizeof(seeding_names[0])); i++) {
+        if (!strcmp(name, seeding_names[i])) {
+            *method = (seeding_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* seeding_name(seeding_t method) {
+    return seeding_names[method];
+}
+
+// Uniform in [0, 1): draw i of a round (see rng.h).
+static inline double rand_unit(unsigned long long round, unsigned long long i) {
+    return rng_unit(rng_key(SEEDING_SEED, round), i);
+}
+
+inline static double euclid_dist_2(int numdims, const double* coord1, const double* coord2) {
+    int    i;
+    double ans = 0.0;
+
+    for (i = 0; i < numdims; i++)
+        ans += (coord1[i] - coord2[i]) * (coord1[i] - coord2[i]);
+
+    return ans;
+}
+
+static void* xmalloc(size_t size) {
+    void* p = malloc(size);
+
+    if (!p) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return p;
+}
+
+// Contiguous share [*lo, *hi) of n objects for the calling thread, like schedule(static).
+static void thread_range(long n, long* lo, long* hi, int* tid) {
+#ifdef _OPENMP
+    int nth = omp_get_num_threads();
+
+    *tid = omp_get_thread_num();
+    *lo  = n * *tid / nth;
+    *hi  = n * (*tid + 1) / nth;
+#else
+    *tid = 0;
+    *lo  = 0;
+    *hi  = n;
+#endif
+}
+
+static int max_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/*
+ * Pick the object at which the running sum of weight[] crosses target. partial[t] holds the sum of
+ * thread t's share, so only one share is scanned.
+ */
+static long pick(const double* weight, long n, const double* partial, int nth, double target) {
+    long   lo, hi, i;
+    int    t;
+    double sum = 0.0;
+
+    for (t = 0; t < nth - 1 && sum + partial[t] <= target; t++)
+        sum += partial[t];
+    lo = n * t / nth;
+    hi = n * (t + 1) / nth;
+    for (i = lo; i < hi - 1; i++) {
+        sum += weight[i];
+        if (sum > target)
+            break;
+    }
+    return i;
+}
+
+static void kmeanspp(const double* objects, int numObjs, int numCoords, int numClusters,
+                     double* clusters) {
+    double* d2      = (double*)xmalloc(numObjs * sizeof(*d2));
+    double* partial = (double*)xmalloc(max_threads() * sizeof(*partial));
+    double  total;
+    long    chosen;
+    int     c, nth = 1;
+
+    chosen = (long)(rand_unit(0, 0) * numObjs);
+    memcpy(clusters, &objects[chosen * numCoords], numCoords * sizeof(*clusters));
+
+    for (c = 1; c <= numClusters; c++) {
+        const double* center = &clusters[(c - 1) * numCoords];
+
+        // fold the last center into D(x)^2, and sum every thread's share for the draw
+#ifdef _OPENMP
+        // clang-format off
+        #pragma omp parallel
+        // clang-format on
+#endif
+        {
+            long   lo, hi, i;
+            int    tid;
+            double sum = 0.0, d;
+
+            thread_range(numObjs, &lo, &hi, &tid);
+            for (i = lo; i < hi; i++) {
+                d = euclid_dist_2(numCoords, &objects[i * numCoords], center);
+                if (c == 1 || d < d2[i])
+                    d2[i] = d;
+                sum += d2[i];
+            }
+            partial[tid] = sum;
+#ifdef _OPENMP
+            if (tid == 0)
+                nth = omp_get_num_threads();
+#endif
+        }
+        if (c == numClusters)
+            break;
+
+        for (total = 0.0, chosen = 0; chosen < nth; chosen++)
+            total += partial[chosen];
+        chosen = pick(d2, numObjs, partial, nth, rand_unit(1, c) * total);
+        memcpy(&clusters[c * numCoords], &objects[chosen * numCoords], numCoords * sizeof(*clusters));
+    }
+
+    free(d2);
+    free(partial);
+}
+
+/*
+ * Weighted k-means++ over a small set of candidates. Serial: there are only about
+ * 2 numClusters x SEEDING_ROUNDS of them.
+ */
+static void weighted_kmeanspp(const double* cand, const double* weight, int numCand, int numCoords,
+                              int numClusters, double* clusters) {
+    double* d2 = (double*)xmalloc(numCand * sizeof(*d2));
+    double  total, sum, d;
+    int     c, i, chosen;
+
+    for (total = 0.0, i = 0; i < numCand; i++)
+        total += weight[i];
+    for (sum = 0.0, chosen = 0; chosen < numCand - 1; chosen++) {
+        sum += weight[chosen];
+        if (sum > rand_unit(SEEDING_ROUNDS + 2, 0) * total)
+            break;
+    }
+
+    for (c = 0; c < numClusters; c++) {
+        memcpy(&clusters[c * numCoords], &cand[chosen * numCoords], numCoords * sizeof(*clusters));
+        total = 0.0;
+        for (i = 0; i < numCand; i++) {
+            d = euclid_dist_2(numCoords, &cand[i * numCoords], &clusters[c * numCoords]);
+            if (c == 0 || d < d2[i])
+                d2[i] = d;
+            total += weight[i] * d2[i];
+        }
+        for (sum = 0.0, chosen = 0; chosen < numCand - 1; chosen++) {
+            sum += weight[chosen] * d2[chosen];
+            if (sum > rand_unit(SEEDING_ROUNDS + 2, c + 1) * total)
+                break;
+        }
+    }
+
+    free(d2);
+}
+
+static void kmeans_parallel(const double* objects, int numObjs, int numCoords, int numClusters,
+                            double* clusters) {
+    double* d2      = (double*)xmalloc(numObjs * sizeof(*d2));
+    int*    nearest = (int*)xmalloc(numObjs * sizeof(*nearest));
+    int     nth     = max_threads();
+    long**  picked  = (long**)xmalloc(nth * sizeof(*picked));  // per-thread sampled objects
+    long*   npicked = (long*)xmalloc(nth * sizeof(*npicked));
+    int     cap     = 4 * numClusters * (SEEDING_ROUNDS + 1);
+    double* cand    = (double*)xmalloc((size_t)cap * numCoords * sizeof(*cand));
+    double* weight;
+    int     numCand = 1, first = 0, round, t;
+    long    k;
+    double  phi     = 0.0;
+    double  oversample = 2.0 * numClusters;
+
+    k = (long)(rand_unit(0, 0) * numObjs);
+    memcpy(cand, &objects[k * numCoords], numCoords * sizeof(*cand));
+
+    for (round = 1;; round++) {
+        // fold the candidates of the last round into D(x)^2 and the nearest candidate
+        phi = 0.0;
+#ifdef _OPENMP
+        // clang-format off
+        #pragma omp parallel for schedule(static) reduction(+ : phi)
+        // clang-format on
+#endif
+        for (k = 0; k < numObjs; k++) {
+            int    c;
+            double d;
+
+            for (c = first; c < numCand; c++) {
+                d = euclid_dist_2(numCoords, &objects[k * numCoords], &cand[c * numCoords]);
+                if (c == 0 || d < d2[k]) {
+                    d2[k]      = d;
+                    nearest[k] = c;
+                }
+            }
+            phi += d2[k];
+        }
+
+        if ((round > SEEDING_ROUNDS && numCand >= numClusters) || round > 100 * SEEDING_ROUNDS ||
+            phi == 0.0)
+            break;
+
+        // every object is a candidate with probability oversample * D(x)^2 / phi
+#ifdef _OPENMP
+        // clang-format off
+        #pragma omp parallel
+        // clang-format on
+#endif
+        {
+            long lo, hi, i;
+            int  tid;
+
+            thread_range(numObjs, &lo, &hi, &tid);
+            picked[tid]  = (long*)xmalloc(64 * sizeof(**picked));
+            npicked[tid] = 0;
+            for (i = lo; i < hi; i++) {
+                if (rand_unit(round, i) * phi < oversample * d2[i]) {
+                    if (npicked[tid] % 64 == 0 && npicked[tid])
+                        picked[tid] = (long*)realloc(picked[tid], (npicked[tid] + 64) * sizeof(**picked));
+                    picked[tid][npicked[tid]++] = i;
+                }
+            }
+#ifdef _OPENMP
+            if (tid == 0)
+                nth = omp_get_num_threads();
+#endif
+        }
+
+        // append them in object order
+        first = numCand;
+        for (t = 0; t < nth; t++) {
+            for (k = 0; k < npicked[t]; k++) {
+                if (numCand == cap) {
+                    cap *= 2;
+                    cand = (double*)realloc(cand, (size_t)cap * numCoords * sizeof(*cand));
+                    if (!cand) {
+                        fprintf(stderr, "Out of memory.\n");
+                        exit(1);
+                    }
+                }
+                memcpy(&cand[numCand * numCoords], &objects[picked[t][k] * numCoords],
+                       numCoords * sizeof(*cand));
+                numCand++;
+            }
+            free(picked[t]);
+        }
+    }
+
+    if (numCand < numClusters) {
+        fprintf(stderr, "kmeans||: only %d distinct candidates for %d clusters.\n", numCand, numClusters);
+        exit(1);
+    }
+
+    // weight every candidate by the number of objects closest to it
+    weight = (double*)calloc(numCand, sizeof(*weight));
+    for (k = 0; k < numObjs; k++)
+        weight[nearest[k]] += 1.0;
+
+    weighted_kmeanspp(cand, weight, numCand, numCoords, numClusters, clusters);
+
+    free(d2);
+    free(nearest);
+    free(picked);
+    free(npicked);
+    free(cand);
+    free(weight);
+}
+
+void seeding_init(seeding_t method, double* objects, int numObjs, int numCoords, int numClusters,
+                  double* clusters) {
+    switch (method) {
+        case SEEDING_KMEANSPP:
+            kmeanspp(objects, numObjs, numCoords, numClusters, clusters);
+            break;
+        case SEEDING_KMEANS_PARALLEL:
+            kmeans_parallel(objects, numObjs, numCoords, numClusters, clusters);
+            break;
+        default:
+            memcpy(clusters, objects, (size_t)numClusters * numCoords * sizeof(*clusters));
+            break;
+    }
+}
@@ -9,6 +9,8 @@
 int _debug;
 #include "alloc.h"
 #include "kmeans.h"
+#include "dataset.h"
+#include "seeding.h"
 
 static void usage(char *argv0) {
     char *help =
@@ -16,8 +18,11 @@ static void usage(char *argv0) {
         "       -c num_clusters    : number of clusters (must be > 1)\n"
         "       -s size            : size of examined dataset\n"
         "       -n num_coords      : number of coordinates\n"
+        "       -f file            : cluster a binary dataset (see dataset.h) instead of\n"
+        "                            generating -s/-n random data\n"
         "       -t threshold       : threshold value (default : 0.001)\n"
         "       -l loop_threshold  : iterations threshold (default : 10)\n"
+        "       -i init            : initial centers, first|kmeans++|kmeans|| (default : first)\n"
         "       -d                 : enable debug mode\n"
         "       -h                 : print this help information\n";
     fprintf(stderr, help, argv0);
@@ -37,6 +42,9 @@ int main(int argc, char **argv)
     double   dataset_size = 0, threshold;
     long    loop_threshold;
     double  io_timing_read;
+    seeding_t init = SEEDING_FIRST;
+    char   * path = NULL;   // binary dataset, if any
+    dataset_t * ds = NULL;
 
     /* some default values */
     _debug         = 0;
@@ -46,7 +54,7 @@ int main(int argc, char **argv)
 
     printf("\n~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n\n");
 
-    while ( (opt = getopt(argc,argv,"n:t:l:c:s:dh")) != EOF) {
+    while ( (opt = getopt(argc,argv,"n:t:l:c:s:f:i:dh")) != EOF) {
         switch (opt) {
             case 'c': numClusters = atol(optarg);
                       break;
@@ -58,6 +66,11 @@ int main(int argc, char **argv)
                       break;
             case 'n': numCoords=atol(optarg);
                       break;
+            case 'f': path = optarg;
+                      break;
+            case 'i': if (seeding_parse(optarg, &init))
+                          usage(argv[0]);
+                      break;
             case 'd': _debug = 1;
                       break;
             case 'h':
@@ -68,7 +81,20 @@ int main(int argc, char **argv)
     if (numClusters <= 1)
         usage(argv[0]);
 
-    numObjs = (dataset_size*1024*1024) / (numCoords*sizeof(double));
+    if (path) {
+        dataset_header_t hdr;
+
+        dataset_read_header(path, &hdr);
+        numObjs = hdr.numObjs;
+        numCoords = hdr.numCoords;
+        dataset_size = (double)numObjs * numCoords * sizeof(double) / (1024*1024);
+        if (numObjs * numCoords > 0x7fffffffL) {
+            printf("Error: %s is too large for the int indices of kmeans().\n", path);
+            return 1;
+        }
+    }
+    else
+        numObjs = (dataset_size*1024*1024) / (numCoords*sizeof(double));
 
     if (numObjs < numClusters) {
         printf("Error: number of clusters must be larger than the number of data points to be clustered.\n");
@@ -76,15 +102,25 @@ int main(int argc, char **argv)
     }
     printf("dataset_size = %.2f MB    numObjs = %ld    numCoords = %ld    numClusters = %ld\n", dataset_size, numObjs, numCoords, numClusters);
 
-    objects = dataset_generation(numObjs, numCoords);
+    if (path) {
+        ds = dataset_open(path, 0, -1);
+        objects = ds->objects;
+    }
+    else
+        objects = dataset_generation(numObjs, numCoords);
 
     // Allocate space for clusters (coordinates of cluster centers)
     clusters = (double*)  malloc(numClusters * numCoords * sizeof(double));
 
-    // The first numClusters elements are selected as initial centers
-    for (i=0; i<numClusters; i++)
-        for (j=0; j<numCoords; j++)
-            clusters[i*numCoords + j] = objects[i*numCoords + j];
+    // The initial centers are the first numClusters elements, or drawn with k-means++/k-means||
+    if (init == SEEDING_FIRST) {
+        seeding_init(init, objects, numObjs, numCoords, numClusters, clusters);
+    } else {
+        double seeding_timing = wtime();
+
+        seeding_init(init, objects, numObjs, numCoords, numClusters, clusters);
+        printf("seeding = %s, total = %7.4fs\n", seeding_name(init), wtime() - seeding_timing);
+    }
 
     // check initial cluster centers for repetition 
     if (check_repeated_clusters(numClusters, numCoords, clusters) == 0) {
@@ -120,7 +156,10 @@ int main(int argc, char **argv)
     }
     
 
-    free(objects);
+    if (ds)
+        dataset_close(ds);
+    else
+        free(objects);
     free(membership);
     free(clusters);
 
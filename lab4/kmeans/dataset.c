@@ -0,0 +1,153 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataset.h"
+
+static void fail(const char* path, const char* what) {
+    fprintf(stderr, "%s: %s\n", path, what);
+    exit(1);
+}
+
+void dataset_read_header(const char* path, dataset_header_t* hdr) {
+    struct stat st;
+    size_t      elsize;
+    int         fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st)) {
+        perror(path);
+        exit(1);
+    }
+    if (pread(fd, hdr, sizeof(*hdr), 0) != sizeof(*hdr) ||
+        memcmp(hdr->magic, DATASET_MAGIC, sizeof(hdr->magic)))
+        fail(path, "not a k-means dataset");
+    if (hdr->version != DATASET_VERSION)
+        fail(path, "unsupported dataset version");
+    if (hdr->dtype != DATASET_FLOAT64 && hdr->dtype != DATASET_FLOAT32)
+        fail(path, "unknown dtype");
+    if (hdr->layout != DATASET_AOS && hdr->layout != DATASET_SOA)
+        fail(path, "unknown layout");
+    if (hdr->numCoords < 1 || hdr->data_offset < sizeof(*hdr))
+        fail(path, "corrupt header");
+
+    elsize = (hdr->dtype == DATASET_FLOAT64) ? sizeof(double) : sizeof(float);
+    if ((uint64_t)st.st_size < hdr->data_offset + hdr->numObjs * hdr->numCoords * elsize)
+        fail(path, "truncated dataset");
+    close(fd);
+}
+
+// Touch one byte of every page of [addr, addr + len).
+static void prefault(const void* addr, size_t len) {
+    long                 page = sysconf(_SC_PAGESIZE);
+    const volatile char* p    = (const volatile char*)((unsigned long)addr & ~(page - 1));
+    const volatile char* end  = (const volatile char*)addr + len;
+    char                 sum  = 0;
+
+    for (; p < end; p += page)
+        sum += *p;
+    (void)sum;
+}
+
+static int prefault_requested(void) {
+    char* env = getenv("KMEANS_PREFAULT");
+
+    return env && strcmp(env, "0");
+}
+
+dataset_t* dataset_open(const char* path, long first, long count) {
+    dataset_header_t hdr;
+    dataset_t*       ds;
+    long             page = sysconf(_SC_PAGESIZE);
+    size_t           elsize, start, len;
+    char*            map;
+    long             i, j, n;
+    int              fd;
+
+    dataset_read_header(path, &hdr);
+    if (count < 0)
+        count = hdr.numObjs - first;
+    if (first < 0 || first + count > (long)hdr.numObjs)
+        fail(path, "object range out of bounds");
+
+    ds = (dataset_t*)calloc(1, sizeof(*ds));
+    if (!ds) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    ds->numObjs   = count;
+    ds->numCoords = hdr.numCoords;
+    n             = hdr.numCoords;
+    elsize        = (hdr.dtype == DATASET_FLOAT64) ? sizeof(double) : sizeof(float);
+
+    // map the requested objects only (aos), or every column (soa), from a page boundary
+    if (hdr.layout == DATASET_AOS) {
+        start = hdr.data_offset + (size_t)first * hdr.numCoords * elsize;
+        len   = (size_t)count * hdr.numCoords * elsize;
+    } else {
+        start = hdr.data_offset;
+        len   = (size_t)hdr.numObjs * hdr.numCoords * elsize;
+    }
+    ds->map_len = len + start % page;
+    if (ds->map_len == 0) {
+        ds->objects = (double*)malloc(1);
+        ds->owned   = 1;
+        return ds;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        perror(path);
+        exit(1);
+    }
+    posix_fadvise(fd, start - start % page, ds->map_len, POSIX_FADV_SEQUENTIAL);
+    // private and writable: the objects arrays of the drivers are not const, writes stay in memory
+    map = (char*)mmap(NULL, ds->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, start - start % page);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    close(fd);
+    madvise(map, ds->map_len, MADV_SEQUENTIAL);
+    madvise(map, ds->map_len, MADV_WILLNEED);
+    ds->map = map;
+    map += start % page;
+
+    if (hdr.dtype == DATASET_FLOAT64 && hdr.layout == DATASET_AOS) {
+        // zero copy: the file is the objects array
+        ds->objects = (double*)map;
+        if (prefault_requested())
+            prefault(ds->objects, len);
+        return ds;
+    }
+
+    // convert into a private buffer
+    ds->objects = (double*)malloc((size_t)count * hdr.numCoords * sizeof(double));
+    ds->owned   = 1;
+    if (!ds->objects) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    for (i = 0; i < count; i++)
+        for (j = 0; j < n; j++) {
+            if (hdr.dtype == DATASET_FLOAT64)
+                ds->objects[i * n + j] = ((double*)map)[(size_t)j * hdr.numObjs + first + i];
+            else if (hdr.layout == DATASET_AOS)
+                ds->objects[i * n + j] = ((float*)map)[i * n + j];
+            else
+                ds->objects[i * n + j] = ((float*)map)[(size_t)j * hdr.numObjs + first + i];
+        }
+    munmap(ds->map, ds->map_len);
+    ds->map = NULL;
+    return ds;
+}
+
+void dataset_close(dataset_t* ds) {
+    if (ds->owned)
+        free(ds->objects);
+    if (ds->map)
+        munmap(ds->map, ds->map_len);
+    free(ds);
+}
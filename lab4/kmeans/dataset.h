@@ -0,0 +1,64 @@
+#ifndef _H_DATASET
+#define _H_DATASET
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary dataset files, an alternative to the synthetic data of dataset_generation().
+ *
+ * A 64-byte header (host byte order) followed, at data_offset, by the coordinates:
+ *
+ *     layout aos: [numObjs][numCoords]     layout soa: [numCoords][numObjs]
+ *
+ * of dtype float64 or float32. csv2bin puts the data at offset DATASET_ALIGN, so that they start on
+ * a page. float64/aos is the layout of the objects array itself: such files are mapped and used in
+ * place, without a copy. Other files are converted into a private buffer.
+ *
+ * Every rank maps only its own slice of the objects, so nothing is read by rank 0 and scattered.
+ * The mapping is advised MADV_SEQUENTIAL/MADV_WILLNEED for kernel readahead. KMEANS_PREFAULT=1
+ * additionally faults every page in before the computation, so that all ranks read their slices
+ * at the same time.
+ *
+ * csv2bin (lab2/kmeans) converts CSV files to this format.
+ */
+
+#define DATASET_MAGIC   "KMEANSDS"
+#define DATASET_VERSION 1
+#define DATASET_ALIGN   4096
+
+enum { DATASET_FLOAT64 = 1, DATASET_FLOAT32 = 2 };
+enum { DATASET_AOS = 0, DATASET_SOA = 1 };
+
+typedef struct dataset_header {
+    char     magic[8];    /* DATASET_MAGIC, not NUL-terminated */
+    uint32_t version;     /* DATASET_VERSION */
+    uint32_t dtype;       /* DATASET_FLOAT64 | DATASET_FLOAT32 */
+    uint32_t layout;      /* DATASET_AOS | DATASET_SOA */
+    uint32_t reserved;
+    uint64_t numObjs;
+    uint64_t numCoords;
+    uint64_t data_offset; /* bytes from the start of the file */
+    uint64_t pad[2];
+} dataset_header_t;
+
+typedef struct dataset {
+    long    numObjs; /* objects in this dataset_t, i.e. in the range that was opened */
+    long    numCoords;
+    double* objects; /* [numObjs][numCoords] */
+    void*   map;     /* mapping of the file, or NULL */
+    size_t  map_len;
+    int     owned; /* objects is a converted copy, to be freed */
+} dataset_t;
+
+/*
+ * Open count objects of the file at path, starting at object first (count < 0: up to the end).
+ * Errors are fatal.
+ */
+dataset_t* dataset_open(const char* path, long first, long count);
+void       dataset_close(dataset_t* ds);
+
+// Read and check the header only.
+void dataset_read_header(const char* path, dataset_header_t* hdr);
+
+#endif
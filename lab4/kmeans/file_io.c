@@ -8,10 +8,12 @@
 #include <unistd.h>    /* read(), close() */
 
 #include "kmeans.h"
+#include "rng.h"
 
 double* dataset_generation(int numObjs, int numCoords, long* rank_numObjs) {
-    double *objects = NULL, *rank_objects = NULL;
-    long    i, j, k;
+    double*            rank_objects = NULL;
+    unsigned long long key          = rng_key(DATASET_SEED, 0);
+    long               first, i, j;
 
     // Random values that will be generated will be between 0 and 10.
     double val_range = 10;
@@ -22,6 +24,7 @@ double* dataset_generation(int numObjs, int numCoords, long* rank_numObjs) {
 
     //* TODO: Calculate number of objects that each rank will examine (*rank_numObjs)
     *rank_numObjs = numObjs / size + ((rank < (numObjs % size)) ? 1 : 0);
+    first         = rank * (numObjs / size) + ((rank < numObjs % size) ? rank : numObjs % size);
 
 
     //! For debugging
@@ -29,62 +32,22 @@ double* dataset_generation(int numObjs, int numCoords, long* rank_numObjs) {
     // MPI_Barrier(MPI_COMM_WORLD);
 
 
-    /* allocate space for objects[][] and read all objects */
-    int sendcounts[size], displs[size];
-    if (rank == 0) {
-        objects = (typeof(objects))malloc(numObjs * numCoords * sizeof(*objects));
-
-        /*
-         * TODO: Calculate sendcounts and displs, which will be used to scatter data to each rank.
-         * Hint: sendcounts: number of elements sent to each rank
-         *       displs: displacement of each rank's data
-         */
-
-        int div   = numObjs / size;
-        int rem   = numObjs % size;
-        int accum = 0;
-
-        for (i = 0; i < size; i++) {
-            sendcounts[i] = numCoords * (div + ((rem > i) ? 1 : 0));
-            displs[i]     = accum;
-            accum += sendcounts[i];
-        }
-    }
-
-    //* TODO: Broadcast the sendcounts and displs arrays to other ranks
-    MPI_Bcast(sendcounts, size, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(displs, size, MPI_INT, 0, MPI_COMM_WORLD);
-
-
-    /* allocate space for objects[][] (for each rank separately) and read all objects */
+    /* allocate space for objects[][] (for each rank separately) */
     rank_objects =
       (typeof(rank_objects))malloc((*rank_numObjs) * numCoords * sizeof(*rank_objects));
 
-    /* rank 0 will generate data for the objects array. This array will be used later to scatter data to each rank. */
-    if (rank == 0) {
-        for (i = 0; i < numObjs; i++) {
-            unsigned int seed = i;
-            for (j = 0; j < numCoords; j++) {
-                objects[i * numCoords + j] = (rand_r(&seed) / ((double)RAND_MAX)) * val_range;
-                if (_debug && i == 0)
-                    printf("object[i=%ld][j=%ld]=%f\n", i, j, objects[i * numCoords + j]);
-            }
+    /*
+     * Every rank generates its own slice, objects [first, first + *rank_numObjs): the generator
+     * is counter-based (see rng.h), so no rank has to generate the whole dataset and scatter it.
+     */
+    for (i = 0; i < *rank_numObjs; i++) {
+        for (j = 0; j < numCoords; j++) {
+            rank_objects[i * numCoords + j] =
+              rng_unit(key, (unsigned long long)(first + i) * numCoords + j) * val_range;
+            if (_debug && first + i == 0)
+                printf("object[i=%ld][j=%ld]=%f\n", first + i, j, rank_objects[i * numCoords + j]);
         }
     }
 
-    //* TODO: Scatter objects to every rank. (hint: each rank may receive different number of objects)
-    MPI_Scatterv(objects,
-                 sendcounts,
-                 displs,
-                 MPI_DOUBLE,
-                 rank_objects,
-                 (*rank_numObjs) * numCoords,
-                 MPI_DOUBLE,
-                 0,
-                 MPI_COMM_WORLD);
-
-    if (rank == 0)
-        free(objects);
-
     return rank_objects;
-}
\ No newline at end of file
+}
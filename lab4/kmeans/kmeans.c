@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "bounds.h"
 #include "kmeans.h"
 
 // square of Euclid distance between two multi-dimensional points
@@ -41,6 +42,70 @@ inline static int find_nearest_cluster(int     numClusters, /* no. clusters */
     return index;
 }
 
+/*
+ * One assignment pass over the local objects, accumulating the new cluster sums; returns the
+ * number of membership changes. Generated for a few numCoords known at compile time, where
+ * euclid_dist_2 and the accumulation inline to fully unrolled code: for small numCoords (-n 2) the
+ * loop overhead dominates otherwise. The sums are formed in the same order, so every version gives
+ * identical results. The bounds path (KMEANS_BOUNDS) keeps its own loop.
+ */
+#define KMEANS_ASSIGN(NAME, DIMS)                                                                  \
+    static double NAME(double* objects,                                                            \
+                       int     numCoords,                                                          \
+                       int     numObjs,                                                            \
+                       int     numClusters,                                                        \
+                       double* clusters,                                                           \
+                       int*    membership,                                                         \
+                       int*    newClusterSize,                                                     \
+                       double* newClusters) {                                                      \
+        double delta = 0.0;                                                                        \
+        int    i, j;                                                                               \
+                                                                                                   \
+        (void)numCoords;                                                                           \
+        for (i = 0; i < numObjs; i++) {                                                           \
+            int index = find_nearest_cluster(numClusters, DIMS, &objects[i * (DIMS)], clusters);   \
+                                                                                                   \
+            if (membership[i] != index)                                                            \
+                delta += 1.0;                                                                      \
+            membership[i] = index;                                                                 \
+                                                                                                   \
+            newClusterSize[index]++;                                                               \
+            for (j = 0; j < (DIMS); j++)                                                           \
+                newClusters[index * (DIMS) + j] += objects[i * (DIMS) + j];                        \
+        }                                                                                          \
+        return delta;                                                                              \
+    }
+
+KMEANS_ASSIGN(assign_generic, numCoords)
+KMEANS_ASSIGN(assign_2, 2)
+KMEANS_ASSIGN(assign_4, 4)
+KMEANS_ASSIGN(assign_8, 8)
+KMEANS_ASSIGN(assign_16, 16)
+KMEANS_ASSIGN(assign_32, 32)
+KMEANS_ASSIGN(assign_64, 64)
+
+typedef double (*assign_fn)(double*, int, int, int, double*, int*, int*, double*);
+
+// pick the specialised pass for numCoords, once per run; other sizes use the generic one
+static assign_fn select_assign(int numCoords) {
+    switch (numCoords) {
+        case 2:
+            return assign_2;
+        case 4:
+            return assign_4;
+        case 8:
+            return assign_8;
+        case 16:
+            return assign_16;
+        case 32:
+            return assign_32;
+        case 64:
+            return assign_64;
+        default:
+            return assign_generic;
+    }
+}
+
 void kmeans(double* objects,        /* in: [numObjs][numCoords] */
             int     numCoords,      /* no. coordinates */
             int     numObjs,        /* no. objects */
@@ -66,6 +131,12 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+    // Bounds of the local objects. The centroids are the same on every rank after the
+    // MPI_Allreduce, so so are their drifts and no extra communication is needed.
+    bounds_t* bnd = bounds_init(numObjs, numClusters, numCoords);
+    long long ndist;
+    assign_fn assign = select_assign(numCoords);
+
     // printf("Rank %d: numObjs = %d\n", rank, numObjs);
 
     // initialize membership
@@ -94,22 +165,29 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
         }
 
         rank_delta = 0.0;
+        ndist      = 0;
+        if (bnd) {
+            bounds_prepare(bnd, clusters);
+            for (i = 0; i < numObjs; i++) {
+                // find the array index of nearest cluster center
+                index = bounds_assign(bnd, &objects[i * numCoords], i, membership[i], clusters, &ndist);
 
-        for (i = 0; i < numObjs; i++) {
-            // find the array index of nearest cluster center
-            index = find_nearest_cluster(numClusters, numCoords, &objects[i * numCoords], clusters);
-
-            // if membership changes, increase rank_delta by 1
-            if (membership[i] != index)
-                rank_delta += 1.0;
+                // if membership changes, increase rank_delta by 1
+                if (membership[i] != index)
+                    rank_delta += 1.0;
 
-            // assign the membership to object i
-            membership[i] = index;
+                // assign the membership to object i
+                membership[i] = index;
 
-            // update new cluster centers : sum of objects located within
-            rank_newClusterSize[index]++;
-            for (j = 0; j < numCoords; j++)
-                rank_newClusters[index * numCoords + j] += objects[i * numCoords + j];
+                // update new cluster centers : sum of objects located within
+                rank_newClusterSize[index]++;
+                for (j = 0; j < numCoords; j++)
+                    rank_newClusters[index * numCoords + j] += objects[i * numCoords + j];
+            }
+            bounds_account(bnd, ndist);
+        } else {
+            rank_delta = assign(
+              objects, numCoords, numObjs, numClusters, clusters, membership, rank_newClusterSize, rank_newClusters);
         }
 
         //* TODO: Perform reduction of cluster data (rank_newClusters, rank_newClusterSize) from local arrays to shared.
@@ -146,6 +224,14 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
     } while (delta > threshold && loop < loop_threshold);
 
     timing = wtime() - timing;
+
+    long long rank_counts[2] = { 0, 0 }, counts[2] = { 0, 0 }; // distances computed and possible
+    if (bnd) {
+        rank_counts[0] = bnd->computed;
+        rank_counts[1] = bnd->possible;
+        MPI_Reduce(rank_counts, counts, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
+
     if (rank == 0) {
         int nodes;
         MPI_Comm_size(MPI_COMM_WORLD, &nodes);
@@ -155,10 +241,17 @@ void kmeans(double* objects,        /* in: [numObjs][numCoords] */
                 loop,
                 timing,
                 timing / loop);
+        if (bnd)
+            fprintf(stdout,
+                    "bounds = %s, distances skipped = %.2f%%\n",
+                    bounds_name(bnd),
+                    counts[1] ? 100.0 * (1.0 - (double)counts[0] / counts[1]) : 0.0);
     }
 
     free(rank_newClusters);
     free(rank_newClusterSize);
     free(newClusters);
     free(newClusterSize);
+    if (bnd)
+        bounds_free(bnd);
 }
\ No newline at end of file
@@ -12,6 +12,13 @@ void kmeans(double* objects,
             int*    membership,
             double* clusters);
 
+/*
+ * Synthetic dataset: coordinate j of object i is draw i * numCoords + j of the counter-based
+ * generator of rng.h (seed DATASET_SEED), scaled to [0, 10). Every rank generates its own slice
+ * of consecutive objects, which is bit-identical to the same objects of a serial run.
+ */
+#define DATASET_SEED 2024
+
 double* dataset_generation(int numObjs, int numCoords, long* rank_numObjs);
 
 int check_repeated_clusters(int, int, double*);
@@ -8,15 +8,20 @@
 #include <unistd.h>    /* getopt() */
 
 int _debug;
+#include "dataset.h"
 #include "kmeans.h"
+#include "seeding.h"
 
 static void usage(char* argv0) {
     char* help = "Usage: %s [switches]\n"
                  "       -c num_clusters    : number of clusters (must be > 1)\n"
                  "       -s size            : size of examined dataset\n"
                  "       -n num_coords      : number of coordinates\n"
+                 "       -f file            : cluster a binary dataset (see dataset.h) instead of\n"
+                 "                            generating -s/-n random data\n"
                  "       -t threshold       : threshold value (default : 0.001)\n"
                  "       -l loop_threshold  : iterations threshold (default : 10)\n"
+                 "       -i init            : initial centers, first|kmeans++|kmeans|| (default : first)\n"
                  "       -d                 : enable debug mode\n"
                  "       -h                 : print this help information\n";
     fprintf(stderr, help, argv0);
@@ -34,11 +39,14 @@ int main(int argc, char** argv) {
       membership; // [rank_numObjs] this array will contain membership information for this rank's objects
     int*
       tot_membership; // [numObjs]      this array will contain membership information for all objects
-    double* objects;  // [numObjs * numCoords] data  objects
-    double* clusters; // [numClusters * numCoords] cluster center
-    double  dataset_size = 0, threshold;
-    long    loop_threshold;
-    double  io_timing_read;
+    double*    objects;  // [numObjs * numCoords] data  objects
+    double*    clusters; // [numClusters * numCoords] cluster center
+    double     dataset_size = 0, threshold;
+    long       loop_threshold;
+    double     io_timing_read, seeding_timing;
+    seeding_t  init = SEEDING_FIRST;
+    char*      path = NULL; // binary dataset, if any
+    dataset_t* ds   = NULL;
 
     /* some default values */
     _debug         = 0;
@@ -46,7 +54,7 @@ int main(int argc, char** argv) {
     loop_threshold = 10;
     numClusters    = 0;
 
-    while ((opt = getopt(argc, argv, "n:t:l:c:s:dh")) != EOF) {
+    while ((opt = getopt(argc, argv, "n:t:l:c:s:f:i:dh")) != EOF) {
         switch (opt) {
             case 'c':
                 numClusters = atol(optarg);
@@ -63,6 +71,13 @@ int main(int argc, char** argv) {
             case 'n':
                 numCoords = atol(optarg);
                 break;
+            case 'f':
+                path = optarg;
+                break;
+            case 'i':
+                if (seeding_parse(optarg, &init))
+                    usage(argv[0]);
+                break;
             case 'd':
                 _debug = 1;
                 break;
@@ -81,7 +96,30 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    numObjs = (dataset_size * 1024 * 1024) / (numCoords * sizeof(double));
+    if (path) {
+        dataset_header_t hdr;
+
+        dataset_read_header(path, &hdr);
+        numObjs      = hdr.numObjs;
+        numCoords    = hdr.numCoords;
+        dataset_size = (double)numObjs * numCoords * sizeof(double) / (1024 * 1024);
+
+        // kmeans() indexes a rank's slice with ints; rank 0 holds the largest one
+        long slice = numObjs / size + ((numObjs % size) ? 1 : 0);
+
+        if (slice * numCoords > 0x7fffffffL) {
+            if (rank == 0) {
+                fprintf(stderr,
+                        "Error: %s is too large for the int indices of kmeans() with %d ranks.\n",
+                        path,
+                        size);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            MPI_Barrier(MPI_COMM_WORLD); // until rank 0 aborts
+        }
+    } else {
+        numObjs = (dataset_size * 1024 * 1024) / (numCoords * sizeof(double));
+    }
 
     if (numObjs < numClusters) {
         if (rank == 0)
@@ -99,26 +137,46 @@ int main(int argc, char** argv) {
                 numCoords,
                 numClusters);
 
-    objects = dataset_generation(numObjs, numCoords, &rank_numObjs);
+    if (path) {
+        // the same slices as dataset_generation() generates, every rank mapping its own
+        long first = rank * (numObjs / size) + ((rank < numObjs % size) ? rank : numObjs % size);
+
+        rank_numObjs   = numObjs / size + ((rank < (numObjs % size)) ? 1 : 0);
+        io_timing_read = wtime();
+        ds             = dataset_open(path, first, rank_numObjs);
+        objects        = ds->objects;
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (rank == 0)
+            printf("dataset = %s, load = %7.4fs\n", path, wtime() - io_timing_read);
+    } else {
+        objects = dataset_generation(numObjs, numCoords, &rank_numObjs);
+    }
 
     // Allocate space for clusters (coordinates of cluster centers)
     clusters = (double*)malloc(numClusters * numCoords * sizeof(double));
 
-    // The first numClusters elements are selected as initial centers. Only rank 0 needs to calculate this, and later broadcast it to all ranks.
-    if (rank == 0) {
-        for (i = 0; i < numClusters; i++)
-            for (j = 0; j < numCoords; j++)
-                clusters[i * numCoords + j] = objects[i * numCoords + j];
+    /*
+     * The initial centers are the first numClusters elements (held by rank 0), or drawn with
+     * k-means++/k-means|| over the slices of all ranks. Every rank ends up with the same centers.
+     */
+    seeding_timing = wtime();
+    seeding_init(init, objects, rank_numObjs, numCoords, numClusters, clusters);
+    seeding_timing = wtime() - seeding_timing;
+
+    if (rank == 0 && init != SEEDING_FIRST)
+        printf("seeding = %s, total = %7.4fs\n", seeding_name(init), seeding_timing);
 
-        // check initial cluster centers for repetition
-        if (check_repeated_clusters(numClusters, numCoords, clusters) == 0) {
+    // check initial cluster centers for repetition. This sorts them, so every rank does it.
+    if (check_repeated_clusters(numClusters, numCoords, clusters) == 0) {
+        if (rank == 0)
             fprintf(stderr,
                     "Error: some initial clusters are repeated. Please select distinct initial "
                     "centers\n");
-            MPI_Finalize();
-            return 1;
-        }
-        /*
+        MPI_Finalize();
+        return 1;
+    }
+    /*
+    if (rank == 0) {
         printf("Initial cluster centers:\n");
         for (i=0; i<numClusters; i++) {
             printf("(0) clusters[%ld] =",i);
@@ -126,11 +184,8 @@ int main(int argc, char** argv) {
                 printf(" %6.6f", clusters[i*numCoords + j]);
             printf("\n");
         }
-        */
     }
-
-    //* TODO: Broadcast initial cluster positions to all ranks
-    MPI_Bcast(clusters, numClusters * numCoords, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    */
 
     // membership: the cluster id for each data object
     membership     = (int*)malloc(rank_numObjs * sizeof(int));
@@ -195,7 +250,10 @@ int main(int argc, char** argv) {
         for (i = 0; i < numObjs; ++i)
             fprintf(stderr, "%d\n", tot_membership[i]);
 
-    free(objects);
+    if (ds)
+        dataset_close(ds);
+    else
+        free(objects);
     free(membership);
     free(tot_membership);
     free(clusters);
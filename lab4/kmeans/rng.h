@@ -0,0 +1,29 @@
+#ifndef _H_RNG
+#define _H_RNG
+
+/*
+ * Counter-based random numbers: the splitmix64 finalizer applied to (key, counter). Draw number
+ * counter of a stream is computed on its own, without the draws before it, so any thread or rank
+ * can produce any part of a sequence and get the same bits as a serial run.
+ *
+ *     key = rng_key(seed, stream);   u = rng_unit(key, counter);   // in [0, 1)
+ */
+
+static inline unsigned long long rng_key(unsigned long long seed, unsigned long long stream) {
+    return seed * 0x9E3779B97F4A7C15ULL + stream * 0xD1B54A32D192ED03ULL;
+}
+
+static inline unsigned long long rng_bits(unsigned long long key, unsigned long long counter) {
+    unsigned long long z = key + (counter + 1) * 0xBF58476D1CE4E5B9ULL;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// The top 53 bits, as a double in [0, 1).
+static inline double rng_unit(unsigned long long key, unsigned long long counter) {
+    return (rng_bits(key, counter) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif
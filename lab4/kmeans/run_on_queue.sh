@@ -40,4 +40,12 @@ for i in 1 2 4 8 16 32 64
 do
 
         mpirun --mca btl tcp,self -np ${i} ./kmeans_mpi -s 256 -n 16 -c 32 -l 10 1>>./output/kmeans.out
-done
\ No newline at end of file
+done
+# Triangle-inequality pruning (see bounds.h)
+for bounds in hamerly elkan
+do
+    for i in 1 2 4 8 16 32 64
+    do
+        mpirun --mca btl tcp,self -x KMEANS_BOUNDS=${bounds} -np ${i} ./kmeans_mpi -s 256 -n 16 -c 32 -l 10 1>>./output/kmeans_${bounds}.out
+    done
+done
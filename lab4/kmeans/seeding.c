@@ -0,0 +1,322 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rng.h"
+#include "seeding.h"
+
+static const char* seeding_names[] = { "first", "kmeans++", "kmeans||" };
+
+int seeding_parse(const char* name, seeding_t* method) {
+    int i;
+
+    for (i = 0; i < (int)(sizeof(seeding_names) / sizeof(seeding_names[0])); i++) {
+        if (!strcmp(name, seeding_names[i])) {
+            *method = (seeding_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* seeding_name(seeding_t method) {
+    return seeding_names[method];
+}
+
+// Uniform in [0, 1): draw i of a round (see rng.h).
+static inline double rand_unit(unsigned long long round, unsigned long long i) {
+    return rng_unit(rng_key(SEEDING_SEED, round), i);
+}
+
+inline static double euclid_dist_2(int numdims, const double* coord1, const double* coord2) {
+    int    i;
+    double ans = 0.0;
+
+    for (i = 0; i < numdims; i++)
+        ans += (coord1[i] - coord2[i]) * (coord1[i] - coord2[i]);
+
+    return ans;
+}
+
+static void* xmalloc(size_t size) {
+    void* p = malloc(size);
+
+    if (!p) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return p;
+}
+
+/*
+ * The slice of every rank: counts[r] objects starting at global index offsets[r]. Returns the total
+ * number of objects.
+ */
+static long slices(int rank_numObjs, int* counts, long* offsets, int size) {
+    long total = 0;
+    int  r;
+
+    MPI_Allgather(&rank_numObjs, 1, MPI_INT, counts, 1, MPI_INT, MPI_COMM_WORLD);
+    for (r = 0; r < size; r++) {
+        offsets[r] = total;
+        total += counts[r];
+    }
+    return total;
+}
+
+// Copy global object g into center on every rank; its owner broadcasts it.
+static void fetch(const double* objects, long g, const int* counts, const long* offsets, int size,
+                  int numCoords, double* center) {
+    int rank, owner;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    for (owner = 0; owner < size - 1 && g >= offsets[owner] + counts[owner]; owner++)
+        ;
+    if (rank == owner)
+        memcpy(center, &objects[(g - offsets[owner]) * numCoords], numCoords * sizeof(*center));
+    MPI_Bcast(center, numCoords, MPI_DOUBLE, owner, MPI_COMM_WORLD);
+}
+
+static void kmeanspp(const double* objects, int rank_numObjs, int numCoords, int numClusters,
+                     double* clusters) {
+    int     rank, size;
+    double* d2;
+    double* partial;
+    int*    counts;
+    long*   offsets;
+    long    numObjs, i, chosen;
+    double  sum, target;
+    int     c, r;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    d2      = (double*)xmalloc((rank_numObjs + 1) * sizeof(*d2));
+    partial = (double*)xmalloc(size * sizeof(*partial));
+    counts  = (int*)xmalloc(size * sizeof(*counts));
+    offsets = (long*)xmalloc(size * sizeof(*offsets));
+    numObjs = slices(rank_numObjs, counts, offsets, size);
+
+    fetch(objects, (long)(rand_unit(0, 0) * numObjs), counts, offsets, size, numCoords, clusters);
+
+    for (c = 1; c < numClusters; c++) {
+        const double* center = &clusters[(c - 1) * numCoords];
+
+        // fold the last center into D(x)^2; every rank learns the sum of every slice
+        sum = 0.0;
+        for (i = 0; i < rank_numObjs; i++) {
+            double d = euclid_dist_2(numCoords, &objects[i * numCoords], center);
+
+            if (c == 1 || d < d2[i])
+                d2[i] = d;
+            sum += d2[i];
+        }
+        MPI_Allgather(&sum, 1, MPI_DOUBLE, partial, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+
+        for (sum = 0.0, r = 0; r < size; r++)
+            sum += partial[r];
+        target = rand_unit(1, c) * sum;
+
+        // the rank whose slice the draw falls into scans it
+        for (sum = 0.0, r = 0; r < size - 1 && (sum + partial[r] <= target || !counts[r]); r++)
+            sum += partial[r];
+        chosen = 0;
+        if (rank == r) {
+            for (i = 0; i < rank_numObjs - 1; i++) {
+                sum += d2[i];
+                if (sum > target)
+                    break;
+            }
+            chosen = i;
+        }
+        MPI_Bcast(&chosen, 1, MPI_LONG, r, MPI_COMM_WORLD);
+        fetch(objects,
+              offsets[r] + chosen,
+              counts,
+              offsets,
+              size,
+              numCoords,
+              &clusters[c * numCoords]);
+    }
+
+    free(d2);
+    free(partial);
+    free(counts);
+    free(offsets);
+}
+
+/*
+ * Weighted k-means++ over a small set of candidates. Every rank runs it on the same input, so no
+ * communication is needed.
+ */
+static void weighted_kmeanspp(const double* cand, const double* weight, int numCand, int numCoords,
+                              int numClusters, double* clusters) {
+    double* d2 = (double*)xmalloc(numCand * sizeof(*d2));
+    double  total, sum, d;
+    int     c, i, chosen;
+
+    for (total = 0.0, i = 0; i < numCand; i++)
+        total += weight[i];
+    for (sum = 0.0, chosen = 0; chosen < numCand - 1; chosen++) {
+        sum += weight[chosen];
+        if (sum > rand_unit(SEEDING_ROUNDS + 2, 0) * total)
+            break;
+    }
+
+    for (c = 0; c < numClusters; c++) {
+        memcpy(&clusters[c * numCoords], &cand[chosen * numCoords], numCoords * sizeof(*clusters));
+        total = 0.0;
+        for (i = 0; i < numCand; i++) {
+            d = euclid_dist_2(numCoords, &cand[i * numCoords], &clusters[c * numCoords]);
+            if (c == 0 || d < d2[i])
+                d2[i] = d;
+            total += weight[i] * d2[i];
+        }
+        for (sum = 0.0, chosen = 0; chosen < numCand - 1; chosen++) {
+            sum += weight[chosen] * d2[chosen];
+            if (sum > rand_unit(SEEDING_ROUNDS + 2, c + 1) * total)
+                break;
+        }
+    }
+
+    free(d2);
+}
+
+static void kmeans_parallel(const double* objects, int rank_numObjs, int numCoords, int numClusters,
+                            double* clusters) {
+    int     rank, size;
+    double* d2;
+    int*    nearest;
+    int*    counts;
+    long*   offsets;
+    int*    npicked; // objects sampled by every rank in this round
+    int*    displs;
+    double* picked;  // this rank's sampled objects
+    double* cand;
+    double* weight;
+    int     cap, numCand = 1, first = 0, round, r, n;
+    long    numObjs, i;
+    double  phi, rank_phi, oversample = 2.0 * numClusters;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    d2      = (double*)xmalloc((rank_numObjs + 1) * sizeof(*d2));
+    nearest = (int*)xmalloc((rank_numObjs + 1) * sizeof(*nearest));
+    counts  = (int*)xmalloc(size * sizeof(*counts));
+    offsets = (long*)xmalloc(size * sizeof(*offsets));
+    npicked = (int*)xmalloc(size * sizeof(*npicked));
+    displs  = (int*)xmalloc(size * sizeof(*displs));
+    picked  = (double*)xmalloc(((size_t)rank_numObjs + 1) * numCoords * sizeof(*picked));
+    cap     = 4 * numClusters * (SEEDING_ROUNDS + 1);
+    cand    = (double*)xmalloc((size_t)cap * numCoords * sizeof(*cand));
+    numObjs = slices(rank_numObjs, counts, offsets, size);
+
+    fetch(objects, (long)(rand_unit(0, 0) * numObjs), counts, offsets, size, numCoords, cand);
+
+    for (round = 1;; round++) {
+        // fold the candidates of the last round into D(x)^2 and the nearest candidate
+        rank_phi = 0.0;
+        for (i = 0; i < rank_numObjs; i++) {
+            int    c;
+            double d;
+
+            for (c = first; c < numCand; c++) {
+                d = euclid_dist_2(numCoords, &objects[i * numCoords], &cand[c * numCoords]);
+                if (c == 0 || d < d2[i]) {
+                    d2[i]      = d;
+                    nearest[i] = c;
+                }
+            }
+            rank_phi += d2[i];
+        }
+        MPI_Allreduce(&rank_phi, &phi, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+        if ((round > SEEDING_ROUNDS && numCand >= numClusters) || round > 100 * SEEDING_ROUNDS ||
+            phi == 0.0)
+            break;
+
+        // every object is a candidate with probability oversample * D(x)^2 / phi
+        n = 0;
+        for (i = 0; i < rank_numObjs; i++) {
+            if (rand_unit(round, offsets[rank] + i) * phi < oversample * d2[i]) {
+                memcpy(&picked[n * numCoords], &objects[i * numCoords], numCoords * sizeof(*picked));
+                n++;
+            }
+        }
+
+        // append everyone's candidates in global object order
+        n *= numCoords;
+        MPI_Allgather(&n, 1, MPI_INT, npicked, 1, MPI_INT, MPI_COMM_WORLD);
+        for (n = 0, r = 0; r < size; r++) {
+            displs[r] = numCand * numCoords + n;
+            n += npicked[r];
+        }
+        first = numCand;
+        numCand += n / numCoords;
+        if (numCand > cap) {
+            while (numCand > cap)
+                cap *= 2;
+            cand = (double*)realloc(cand, (size_t)cap * numCoords * sizeof(*cand));
+            if (!cand) {
+                fprintf(stderr, "Out of memory.\n");
+                exit(1);
+            }
+        }
+        MPI_Allgatherv(picked,
+                       npicked[rank],
+                       MPI_DOUBLE,
+                       cand,
+                       npicked,
+                       displs,
+                       MPI_DOUBLE,
+                       MPI_COMM_WORLD);
+    }
+
+    if (numCand < numClusters) {
+        if (rank == 0)
+            fprintf(stderr,
+                    "kmeans||: only %d distinct candidates for %d clusters.\n",
+                    numCand,
+                    numClusters);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // weight every candidate by the number of objects closest to it, over all ranks
+    weight = (double*)calloc(numCand, sizeof(*weight));
+    for (i = 0; i < rank_numObjs; i++)
+        weight[nearest[i]] += 1.0;
+    MPI_Allreduce(MPI_IN_PLACE, weight, numCand, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    weighted_kmeanspp(cand, weight, numCand, numCoords, numClusters, clusters);
+
+    free(d2);
+    free(nearest);
+    free(counts);
+    free(offsets);
+    free(npicked);
+    free(displs);
+    free(picked);
+    free(cand);
+    free(weight);
+}
+
+void seeding_init(seeding_t method, double* objects, int rank_numObjs, int numCoords,
+                  int numClusters, double* clusters) {
+    int rank;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    switch (method) {
+        case SEEDING_KMEANSPP:
+            kmeanspp(objects, rank_numObjs, numCoords, numClusters, clusters);
+            break;
+        case SEEDING_KMEANS_PARALLEL:
+            kmeans_parallel(objects, rank_numObjs, numCoords, numClusters, clusters);
+            break;
+        default:
+            // rank 0 holds the first objects
+            if (rank == 0)
+                memcpy(clusters, objects, (size_t)numClusters * numCoords * sizeof(*clusters));
+            MPI_Bcast(clusters, numClusters * numCoords, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            break;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef _H_SEEDING
+#define _H_SEEDING
+
+/*
+ * Choice of the initial cluster centers (-i on the command line):
+ *
+ *  - first:    the first numClusters objects (the original behaviour).
+ *  - kmeans++: Arthur and Vassilvitskii, "k-means++: The Advantages of Careful Seeding". Every
+ *              new center is drawn with probability proportional to D(x)^2, the squared distance
+ *              of x to the closest center chosen so far. numClusters passes over the dataset.
+ *  - kmeans||: Bahmani et al., "Scalable K-Means++". A few rounds each draw about 2 numClusters
+ *              candidates at once, every object independently with probability proportional to
+ *              D(x)^2. The candidates are weighted by the number of objects closest to them and
+ *              reduced to numClusters centers with a weighted k-means++. Only SEEDING_ROUNDS
+ *              passes over the dataset.
+ *
+ * Every rank passes its own slice of the dataset and all ranks end up with the same centers. Random
+ * numbers come from the counter-based generator of rng.h, keyed by (SEEDING_SEED, round) and
+ * indexed by global object, so the draws do not depend on the number of ranks.
+ */
+
+typedef enum { SEEDING_FIRST = 0, SEEDING_KMEANSPP, SEEDING_KMEANS_PARALLEL } seeding_t;
+
+#define SEEDING_SEED   42
+#define SEEDING_ROUNDS 5 /* kmeans|| rounds */
+
+// Returns 0 and sets *method if name is first, kmeans++ or kmeans||.
+int         seeding_parse(const char* name, seeding_t* method);
+const char* seeding_name(seeding_t method);
+
+void seeding_init(seeding_t method,
+                  double*   objects,  /* in: [rank_numObjs][numCoords] */
+                  int       rank_numObjs,
+                  int       numCoords,
+                  int       numClusters,
+                  double*   clusters); /* out: [numClusters][numCoords] */
+
+#endif